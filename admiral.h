@@ -0,0 +1,47 @@
+#include <X11/extensions/Xinerama.h>
+#include <X11/extensions/sync.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xresource.h>
+#include <X11/Xatom.h>
+#include <X11/cursorfont.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <signal.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string.h>
+#include <map>
+#include <vector>
+#include <err.h>
+#include <time.h>
+#include <atomic>
+#include <functional>
+#include <poll.h>
+#include <sys/inotify.h>
+
+#include "config.h"
+#include "variables.h"
+#include "util.h"
+#include "log.h"
+#include "backend.h"
+#include "resources.h"
+#include "x11.h"
+#include "ewmh.h"
+#include "text.h"
+#include "render.h"
+#include "rules.h"
+#include "manage.h"
+#include "client.h"
+#include "mru.h"
+#include "stack.h"
+#include "freespace.h"
+#include "workspaces.h"
+#include "sync.h"
+#include "ping.h"
+#include "event.h"
+#include "settings.h"
+#include "bar.h"
+#include "connection.h"
+#include "load.h"
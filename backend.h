@@ -0,0 +1,78 @@
+
+struct FrameState;
+void render_submit (const FrameState *state);
+
+struct DisplayBackend
+{
+  virtual ~DisplayBackend () {}
+  virtual Atom intern_atom (const char *name) = 0;
+  virtual void move_resize_window (Window w, int x, int y, int width, int height) = 0;
+  virtual void set_border_width (Window w, int width) = 0;
+  virtual void map_window (Window w) = 0;
+  virtual void unmap_window (Window w) = 0;
+  virtual void raise_window (Window w) = 0;
+  virtual void restack_windows (Window *windows, int count) = 0;
+  virtual void set_input_focus (Window w) = 0;
+  virtual void send_configure (Window w, int x, int y, int width, int height) = 0;
+  virtual void change_property (Window w, Atom property, Atom type, int format, int mode,
+                                const void *data, int count) = 0;
+  virtual XPoint query_pointer () = 0;
+  virtual void draw_frame (const FrameState *state) = 0;
+};
+
+struct XlibBackend : DisplayBackend
+{
+  Atom intern_atom (const char *name) {
+    return XInternAtom(dpy, name, False);
+  }
+  void move_resize_window (Window w, int x, int y, int width, int height) {
+    XMoveResizeWindow(dpy, w, x, y, width, height);
+  }
+  void set_border_width (Window w, int width) {
+    XSetWindowBorderWidth(dpy, w, width);
+  }
+  void map_window (Window w) {
+    XMapWindow(dpy, w);
+  }
+  void unmap_window (Window w) {
+    XUnmapWindow(dpy, w);
+  }
+  void raise_window (Window w) {
+    XRaiseWindow(dpy, w);
+  }
+  void restack_windows (Window *windows, int count) {
+    XRestackWindows(dpy, windows, count);
+  }
+  void set_input_focus (Window w) {
+    XSetInputFocus(dpy, w, RevertToPointerRoot, CurrentTime);
+  }
+  void send_configure (Window w, int x, int y, int width, int height) {
+    XConfigureEvent ev = {
+      .type = ConfigureNotify,
+      .event = w,
+      .window = w,
+      .x = x,
+      .y = y,
+      .width = width,
+      .height = height
+    };
+    XSendEvent(dpy, w, False, StructureNotifyMask, (XEvent *) &ev);
+  }
+  void change_property (Window w, Atom property, Atom type, int format, int mode,
+                        const void *data, int count) {
+    XChangeProperty(dpy, w, property, type, format, mode, (unsigned char *) data, count);
+  }
+  XPoint query_pointer () {
+    int x, y;
+    Window a, b;
+    int c, d;
+    unsigned int e;
+    XQueryPointer(dpy, root, &a, &b, &x, &y, &c, &d, &e);
+    return XPoint{(short)x, (short)y};
+  }
+  void draw_frame (const FrameState *state) {
+    render_submit(state);
+  }
+} xlib_backend;
+
+DisplayBackend *backend = &xlib_backend;
@@ -0,0 +1,159 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+
+struct Bar
+{
+  Window window;
+  Pixmap buffer;
+  cairo_surface_t *surface;
+  XineramaScreenInfo *screen;
+  int width, height;
+  bool valid;
+  uint32_t desktops;
+  std::string title, status;
+  int status_x;
+  TextCache labels[DesktopCount], title_text, status_text;
+};
+
+std::vector<Bar> bars;
+std::vector<Window> bar_windows;
+std::string bar_status;
+int bar_status_width;
+
+void bar_fill (Bar& bar, int x, int width, unsigned long pixel)
+{
+  auto gc = XSharedGC(DefaultDepth(dpy, screen_number));
+  XSetForeground(dpy, gc, pixel);
+  XFillRectangle(dpy, bar.buffer, gc, x, 0, width, bar.height);
+}
+
+void bar_text (Bar& bar, int x, int width, TextCache& cache, const std::string& text, unsigned long pixel)
+{
+  auto &shaped = shape_text(cache, text, width);
+  auto c = cairo_create(bar.surface);
+  cairo_set_scaled_font(c, title_font);
+  cairo_set_source_rgb(c, (pixel >> 16 & 0xFF) / 255.0, (pixel >> 8 & 0xFF) / 255.0, (pixel & 0xFF) / 255.0);
+  cairo_translate(c, x, bar.height - BorderWidth + 1);
+  cairo_show_glyphs(c, shaped.glyphs.data(), shaped.glyphs.size());
+  cairo_destroy(c);
+}
+
+void bar_draw (Bar& bar)
+{
+  int cell = bar.height, left = cell * DesktopCount;
+  auto title = focused && find_screen(focused->cursor().x, focused->cursor().y) == bar.screen
+    ? focused->title : std::string();
+  int status_width = std::min(bar_status_width, bar.width / 2),
+      status_x = bar.width - status_width - BorderWidth * 2;
+  bool moved = status_x != bar.status_x;
+  auto desktops = monitor_desktops[bar.screen - screens];
+  if (!bar.valid || bar.desktops != desktops) {
+    for (int i = 0; i < DesktopCount; ++i) {
+      bool on = desktops & 1 << i;
+      bar_fill(bar, i * cell, cell, on ? active_frame_pixel : inactive_frame_pixel);
+      bar_text(bar, i * cell + cell / 3, cell - cell / 3, bar.labels[i], std::to_string(i + 1),
+               on ? frame_text_pixel : inactive_text_pixel);
+    }
+    cairo_surface_flush(bar.surface);
+    XClearArea(dpy, bar.window, 0, 0, left, cell, False);
+  }
+  if (!bar.valid || moved || bar.title != title) {
+    bar_fill(bar, left, status_x - left, inactive_frame_pixel);
+    bar_text(bar, left + BorderWidth * 2, status_x - left - BorderWidth * 4, bar.title_text, title, inactive_text_pixel);
+    cairo_surface_flush(bar.surface);
+    XClearArea(dpy, bar.window, left, 0, status_x - left, cell, False);
+  }
+  if (!bar.valid || moved || bar.status != bar_status) {
+    bar_fill(bar, status_x, bar.width - status_x, inactive_frame_pixel);
+    bar_text(bar, status_x + BorderWidth, status_width + BorderWidth, bar.status_text, bar_status, inactive_text_pixel);
+    cairo_surface_flush(bar.surface);
+    XClearArea(dpy, bar.window, status_x, 0, bar.width - status_x, cell, False);
+  }
+  bar.valid = true;
+  bar.desktops = desktops;
+  bar.title = title;
+  bar.status = bar_status;
+  bar.status_x = status_x;
+}
+
+void bar_update (bool force)
+{
+  for (auto &bar : bars) {
+    if (force)
+      bar.valid = false;
+    bar_draw(bar);
+  }
+}
+
+void bar_read_status (int fd)
+{
+  static std::string pending;
+  char buf[1024];
+  ssize_t len;
+  while ((len = read(fd, buf, sizeof(buf))) > 0)
+    pending.append(buf, len);
+  auto end = pending.rfind('\n');
+  if (end == std::string::npos) return;
+  auto begin = end ? pending.rfind('\n', end - 1) : std::string::npos;
+  begin = begin == std::string::npos ? 0 : begin + 1;
+  bar_status = pending.substr(begin, end - begin);
+  pending.erase(0, end + 1);
+  bar_status_width = text_width(bar_status);
+  each_connection([] { bar_update(false); });
+}
+
+void bar_init ()
+{
+  std::string position = setting("bar", "top");
+  if (position == "off") return;
+  for (int i = 0; i < screen_count; ++i) {
+    auto s = &screens[i];
+    Bar bar {};
+    bar.screen = s;
+    bar.width = s->width;
+    bar.height = HeadlineHeight;
+    int y = position == "bottom" ? s->y_org + s->height - bar.height : s->y_org;
+    XSetWindowAttributes wa;
+    wa.override_redirect = True;
+    bar.window = XCreateWindow(dpy, root, s->x_org, y, bar.width, bar.height, 0, CopyFromParent,
+                               InputOutput, CopyFromParent, CWOverrideRedirect, &wa);
+    bar.buffer = XCreatePixmap(dpy, bar.window, bar.width, bar.height, DefaultDepth(dpy, screen_number));
+    track(RWindow, 1);
+    track(RPixmap, 1);
+    bar.surface = cairo_xlib_surface_create(dpy, bar.buffer, DefaultVisual(dpy, screen_number),
+                                            bar.width, bar.height);
+    XSetWindowBackgroundPixmap(dpy, bar.window, bar.buffer);
+    XMapWindow(dpy, bar.window);
+    bars.push_back(bar);
+    bar_windows.push_back(bar.window);
+    fixed_struts.push_back(Strut { position == "bottom" ? EdgeBottom : EdgeTop,
+                                   Area { s->x_org, y, s->x_org + bar.width, y + bar.height } });
+  }
+  bar_update(true);
+}
+
+void bar_reset ()
+{
+  for (auto &bar : bars) {
+    cairo_surface_destroy(bar.surface);
+    XFreePixmap(dpy, bar.buffer);
+    XDestroyWindow(dpy, bar.window);
+    track(RWindow, -1);
+    track(RPixmap, -1);
+  }
+  bars.clear();
+  bar_windows.clear();
+  fixed_struts.clear();
+  bar_init();
+  update_struts();
+  restack();
+}
+
+void bar_status_init ()
+{
+  auto path = config_path("status");
+  mkfifo(path.c_str(), 0600);
+  int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd >= 0)
+    watch_fd(fd, [fd] { bar_read_status(fd); });
+}
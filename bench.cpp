@@ -0,0 +1,132 @@
+#include "admiral.h"
+#include <chrono>
+
+struct Request
+{
+  const char *name;
+  Window window;
+};
+
+struct FakeBackend : DisplayBackend
+{
+  std::map<std::string, Atom> atoms;
+  std::vector<Request> requests;
+  XPoint pointer;
+  void record (const char *name, Window w) { requests.push_back(Request { name, w }); }
+  Atom intern_atom (const char *name) {
+    auto &atom = atoms[name];
+    if (!atom) atom = atoms.size();
+    return atom;
+  }
+  void move_resize_window (Window w, int x, int y, int width, int height) { record("move_resize_window", w); }
+  void set_border_width (Window w, int width) { record("set_border_width", w); }
+  void map_window (Window w) { record("map_window", w); }
+  void unmap_window (Window w) { record("unmap_window", w); }
+  void raise_window (Window w) { record("raise_window", w); }
+  void restack_windows (Window *windows, int count) { record("restack_windows", count ? windows[0] : None); }
+  void set_input_focus (Window w) { record("set_input_focus", w); }
+  void send_configure (Window w, int x, int y, int width, int height) { record("send_configure", w); }
+  void change_property (Window w, Atom property, Atom type, int format, int mode,
+                        const void *data, int count) { record("change_property", w); }
+  XPoint query_pointer () { record("query_pointer", root); return pointer; }
+  void draw_frame (const FrameState *state) { delete state; }
+} fake;
+
+void populate (int count)
+{
+  for (auto c : stack_order)
+    delete c;
+  clients.clear();
+  stack_order.clear();
+  stacked_frames.clear();
+  client_list.clear();
+  client_list_stacking.clear();
+  free_spaces.clear();
+  focused = 0;
+  mru_heads.assign(screen_count * DesktopCount, 0);
+  current_desktop = 1;
+  current_monitor = 0;
+  monitor_desktops.assign(screen_count, 1);
+  srand(count);
+  for (int i = 0; i < count; ++i) {
+    auto c = new XClient();
+    c->frame = 1000 + i * 2;
+    c->child = 1001 + i * 2;
+    c->type = atom("_NET_WM_WINDOW_TYPE_NORMAL");
+    c->x = rand() % 1600;
+    c->y = rand() % 900;
+    c->width = 100 + rand() % 600;
+    c->height = 100 + rand() % 400;
+    c->right = c->x + c->width;
+    c->bottom = c->y + c->height;
+    c->desktop = 1 << rand() % DesktopCount;
+    c->mapped = true;
+    c->viewable = c->desktop & current_desktop;
+    clients[c->frame] = clients[c->child] = c;
+    stack_layer(*c);
+    stack_order.push_back(c);
+    freespace_update(*c);
+  }
+  restack();
+  for (auto c : stack_order) {
+    if (c->viewable) {
+      focus(*c);
+      break;
+    }
+  }
+}
+
+bool verbose;
+
+template<typename F>
+void measure (const char *name, int count, int ops, F fn)
+{
+  fake.requests.clear();
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < ops; ++i)
+    fn(i);
+  auto end = std::chrono::steady_clock::now();
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  printf("%-14s %6d %12.0f %10.2f\n", name, count, (double) ns / ops, (double) fake.requests.size() / ops);
+  if (!verbose) return;
+  std::map<std::string, long> by_name;
+  for (auto &r : fake.requests)
+    ++by_name[r.name];
+  for (auto &n : by_name)
+    printf("  %-20s %10.2f\n", n.first.c_str(), (double) n.second / ops);
+}
+
+int main (int argc, const char *argv[])
+{
+  verbose = argc > 1 && !strcmp(argv[1], "-v");
+  backend = &fake;
+  root = 1;
+  screen_count = 1;
+  screens = new XineramaScreenInfo[1];
+  screens->x_org = 0;
+  screens->y_org = 0;
+  screens->width = 1920;
+  screens->height = 1080;
+  fake.pointer = XPoint{ 960, 540 };
+  printf("%-14s %6s %12s %10s\n", "operation", "n", "ns/op", "requests");
+  for (int count : { 10, 100, 1000, 10000 }) {
+    populate(count);
+    std::vector<XClient *> order(stack_order);
+    int ops = std::max(10, 100000 / count);
+    measure("move_resize", count, ops, [&] (int i) {
+      auto &c = *order[i % count];
+      move_resize(c, c.x + 1, c.y, c.width, c.height);
+    });
+    measure("fill", count, ops, [&] (int i) {
+      fill(*order[i % count]);
+    });
+    measure("focus_towards", count, ops, [&] (int i) {
+      static const int dirs[][2] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+      focus_towards(dirs[i % 4][0], dirs[i % 4][1]);
+    });
+    measure("set_desktop", count, ops, [&] (int i) {
+      set_desktop(1 << i % DesktopCount);
+    });
+  }
+  return 0;
+}
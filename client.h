@@ -1,6 +1,4 @@
 #include <sstream>
-#include <cairo/cairo.h>
-#include <cairo/cairo-xlib.h>
 
 struct cursor_t {
   int x, y;
@@ -9,11 +7,39 @@ struct cursor_t {
   }
 } cursor;
 
+struct XClient;
+
+struct MruLink
+{
+  XClient *prev, *next;
+};
+
 struct XClient
 {
   Window frame, child;
-  GC gc;
   std::string title;
+  std::string wm_class;
+  Atom type;
+  Window transient_for;
+  bool above;
+  int layer;
+  long map_requested, map_latency;
+  long configure_requests;
+  std::vector<long> protocols;
+  XID sync_counter;
+  XSyncAlarm sync_alarm;
+  int64_t sync_value;
+  bool sync_pending, sync_deferred;
+  int sync_next[4];
+  Timer sync_timer;
+  pid_t pid;
+  long cpu_time, sampled_at, rss, shown_rss;
+  int cpu, shown_cpu;
+  std::string load;
+  std::vector<long> strut;
+  bool hung;
+  Timer ping_timer, kill_timer;
+  FrameState drawn;
   union { int x, left; };
   union { int y, top; };
   int width, height;
@@ -21,9 +47,12 @@ struct XClient
   XineramaScreenInfo *fullscreen;
   bool undecorated;
   uint32_t desktop;
+  int monitor;
   XSizeHints hints;
   bool mapped;
+  bool viewable;
   bool shaded;
+  MruLink mru[DesktopCount];
   cursor_t cursor () {
     return (cursor_t) { x + width / 2, y + height / 2 };
   }
@@ -45,94 +74,100 @@ bool IsClient (Window w)
 
 XClient *focused;
 
-XFontStruct *fs;
+void stack_add (XClient& client);
+void stack_remove (XClient& client);
+void stack_raise (XClient& client);
+void restack ();
+void stack_layer (XClient& client);
+void bar_update (bool force = false);
+void sync_forget (XClient& client);
+void ping (XClient& client);
+void freespace_update (XClient& client);
+void mru_touch (XClient& client);
+void mru_remove (XClient& client);
+void unfocus_others ();
+void load_watch (XClient& client);
+void select_monitor (int monitor);
+void set_monitor (XClient& client, int monitor);
+void find_space (XineramaScreenInfo *s, uint32_t desktop, Placement& placement);
 
 void XDrawFrame (XClient& client, bool active)
 {
+  if (client.undecorated || client.fullscreen) return;
   int w = client.width + BorderWidth * 2 - 1,
-      h = client.height + BorderWidth * 2 + HeadlineHeight - 1,
-      t = BorderWidth + HeadlineHeight - 1,
-      l = BorderWidth - 1,
-      b = h - l,
-      r = w - l;
-  int color = 0xCCCCCC, tint = 0x111111;
-  double text = 0.5;
-  if (active) {
-    color = 0x444488;
-    tint = 0x333333;
-    text = 0.8;
-  }
-  if (client.undecorated) {
-  } else {
-    if (client.shaded) {
-      h = BorderWidth + HeadlineHeight - 1;
-      b = h - l;
-    }
-    XSetForeground(dpy, client.gc, color);
-    XFillRectangle(dpy, client.frame, client.gc, 0, 0, w, h);
-    if (!client.shaded) {
-      XSetForeground(dpy, client.gc, color - tint);
-      XDrawLine(dpy, client.frame, client.gc, l, t, r, t);
-      XDrawLine(dpy, client.frame, client.gc, l, t, l, b);
-      XSetForeground(dpy, client.gc, color + tint);
-      XDrawLine(dpy, client.frame, client.gc, r, t, r, b);
-      XDrawLine(dpy, client.frame, client.gc, l, b, r, b);
-    }
-    XSetForeground(dpy, client.gc, color - tint);
-    XDrawLine(dpy, client.frame, client.gc, w, 0, w, h);
-    XDrawLine(dpy, client.frame, client.gc, 0, h, w, h);
-    XSetForeground(dpy, client.gc, color + tint);
-    XDrawLine(dpy, client.frame, client.gc, 0, 0, w, 0);
-    XDrawLine(dpy, client.frame, client.gc, 0, 0, 0, h);
-    auto cs = cairo_xlib_surface_create(dpy, client.frame, XDefaultVisual(dpy, XDefaultScreen(dpy)), w, h);
-    auto c = cairo_create(cs);
-    cairo_set_source_rgb(c, text, text, text);
-    cairo_move_to(c, BorderWidth * 2, HeadlineHeight - BorderWidth + 1);
-    cairo_show_text(c, client.title.c_str());
-    std::stringstream ss;
-    if ((client.desktop & 0x3) == 0x3) ss << "*";
-    ss << "[" << __builtin_ctz(current_desktop) + 1 << "]";
-    cairo_text_extents_t te;
-    cairo_text_extents(c, ss.str().c_str(), &te);
-    cairo_move_to(c, w - te.x_advance - BorderWidth * 2, HeadlineHeight - BorderWidth + 1);
-    cairo_show_text(c, ss.str().c_str());
+      h = client.height + BorderWidth * 2 + HeadlineHeight - 1;
+  if (client.shaded)
+    h = BorderWidth + HeadlineHeight - 1;
+  std::stringstream ss;
+  if (load_overlay && !client.load.empty()) ss << client.load << " ";
+  if ((client.desktop & 0x3) == 0x3) ss << "*";
+  ss << "[" << __builtin_ctz(monitor_desktops[client.monitor]) + 1 << "]";
+  FrameState state { client.frame, w, h, client.shaded, active, false,
+                     client.hung ? client.title + " (not responding)" : client.title, ss.str(),
+                     BorderWidth, HeadlineHeight,
+                     active ? active_frame_pixel : inactive_frame_pixel,
+                     active ? frame_text_pixel : inactive_text_pixel };
+  state.connection = connection_index;
+  state.screen = screen_number;
+  if (state == client.drawn) {
+    ++stats.redraws_avoided;
+    return;
   }
+  client.drawn = state;
+  backend->draw_frame(new FrameState(state));
+}
+
+bool supports (XClient& client, const char *protocol)
+{
+  return std::count(client.protocols.begin(), client.protocols.end(), (long) atom(protocol));
 }
 
-void XDeleteClient (Window w)
+void XDeleteClient (XClient& client)
 {
+  if (!supports(client, "WM_DELETE_WINDOW")) {
+    XKillClient(dpy, client.child);
+    return;
+  }
   XClientMessageEvent cme;
   cme.type = ClientMessage;
-  cme.window = w;
+  cme.window = client.child;
   cme.message_type = atom("WM_PROTOCOLS");
   cme.format = 32;
   cme.data.l[0] = atom("WM_DELETE_WINDOW");
-  cme.data.l[1] = 0;
-  XSendEvent(dpy, w, false, 0, (XEvent *) &cme);
+  cme.data.l[1] = CurrentTime;
+  XSendEvent(dpy, client.child, false, 0, (XEvent *) &cme);
 }
 
 void XDestroyClient (Window w)
 {
-  if (IsClient(w)) return;
+  if (!IsClient(w)) return;
   auto c = clients[w];
+  ewmh_remove_client(c->child);
+  if (c == focused)
+    focused = 0;
+  stack_remove(*c);
+  bar_update();
+  sync_forget(*c);
+  mru_remove(*c);
+  cancel_timer(c->ping_timer);
+  cancel_timer(c->kill_timer);
+  auto forget = new FrameState { c->frame, 0, 0, false, false, true };
+  forget->connection = connection_index;
+  forget->screen = screen_number;
+  backend->draw_frame(forget);
   XDestroyWindow(dpy, c->frame);
   clients.erase(c->frame);
   clients.erase(c->child);
+  freespace_update(*c);
   delete c;
+  track(RWindow, -1);
+  track(RClient, -1);
+  dump_resources();
 }
 
-struct MotifWmHints {
-   unsigned long flags;
-   unsigned long functions;
-   unsigned long decorations;
-   long input_mode;
-   unsigned long status;
-};
-
-void ProcessHints (XClient& client)
+void ProcessHints (XClient& client, const ManageInfo& info)
 {
-  long mask;
-  XGetWMNormalHints(dpy, client.child, &client.hints, &mask);
+  client.hints = info.hints;
   if ((client.hints.flags & PMinSize)== 0)
     client.hints.min_height = client.hints.min_width = 0;
   if ((client.hints.flags & PMaxSize) == 0)
@@ -142,12 +177,15 @@ void ProcessHints (XClient& client)
     client.hints.base_width = client.hints.min_width;
   if ((client.hints.flags & PResizeInc) == 0)
     client.hints.width_inc = client.hints.height_inc = 1;
-  MotifWmHints mh;
   client.undecorated = false;
-  if (getstruct(client.child, "_MOTIF_WM_HINTS", 32, mh)) {
-    if ((mh.flags & 2) == 2)
-      client.undecorated = mh.decorations == 0;
-  }
+  if (info.has_motif && (info.motif.flags & 2) == 2)
+    client.undecorated = info.motif.decorations == 0;
+}
+
+void constrain (XClient& client, int& width, int& height)
+{
+  width = std::max(client.hints.min_width, std::min(client.hints.max_width, width));
+  height = std::max(client.hints.min_height, std::min(client.hints.max_height, height));
 }
 
 void unfocus (XClient& client)
@@ -156,41 +194,64 @@ void unfocus (XClient& client)
 }
 
 void set_desktop (XClient& client, uint32_t num);
+void set_fullscreen (XClient& client, bool on, XineramaScreenInfo *s = 0);
+
+XClient& XManageClient (const ManageInfo& info)
+{
+  auto w = info.window;
+  auto frame = XCreateWindow(dpy, root, 0, 0, 1, 1, 1, CopyFromParent,
+                             InputOutput, CopyFromParent, 0, 0);
+  track(RWindow, 1);
+  track(RClient, 1);
+  auto c = new XClient { .frame = frame, .child = w };
+  auto p = prefetched_pointer;
+  auto s = find_screen(p.x, p.y);
+  Placement placement { p.x - s->width / 6, p.y - s->height / 6, s->width / 3, s->height / 3, monitor_desktops[s - screens], false, false };
+  place(info.cls, info.instance, info.role, info.title, s, placement);
+  if (!placement.positioned)
+    find_space(s, placement.desktop, placement);
+  c->wm_class = info.cls;
+  c->title = info.title;
+  c->type = info.type;
+  c->transient_for = info.transient_for;
+  c->protocols = info.protocols;
+  c->sync_counter = info.sync_counter;
+  c->pid = info.machine == hostname() ? info.pid : 0;
+  c->strut = info.strut;
+  c->above = std::count(info.state.begin(), info.state.end(), (long) atom("_NET_WM_STATE_ABOVE"));
+  c->desktop = info.has_desktop ? info.desktop : placement.desktop;
+  c->x = placement.x;
+  c->y = placement.y;
+  c->width = placement.width;
+  c->height = placement.height;
+  c->right = c->x + c->width;
+  c->bottom = c->y + c->height;
+  c->monitor = find_screen(c->cursor().x, c->cursor().y) - screens;
+  c->mapped = false;
+  XSetWindowBorder(dpy, frame, BlackPixel(dpy, 0));
+  XAddToSaveSet(dpy, w);
+  XReparentWindow(dpy, w, frame, 4, HeadlineHeight);
+  XSelectInput(dpy, frame, ButtonPressMask | EnterWindowMask | SubstructureNotifyMask | SubstructureRedirectMask);
+  XSelectInput(dpy, w, PropertyChangeMask | StructureNotifyMask);
+  ProcessHints(*c, info);
+  if (placement.undecorated || c->type == atom("_NET_WM_WINDOW_TYPE_DOCK"))
+    c->undecorated = true;
+  clients[frame] = clients[w] = c;
+  stack_add(*c);
+  load_watch(*c);
+  ewmh_set_desktop(w, c->desktop);
+  if (placement.fullscreen || std::count(info.state.begin(), info.state.end(), (long) atom("_NET_WM_STATE_FULLSCREEN")))
+    set_fullscreen(*c, true);
+  dump_resources();
+  return *c;
+}
 
 XClient& XFindClient (Window w, bool create, bool focus = false)
 {
   if (IsClient(w)) {
     return *clients[w];
   } else if (create) {
-    auto frame = XCreateWindow(dpy, root, 0, 0, 1, 1, 1, CopyFromParent,
-                               InputOutput, CopyFromParent, 0, 0);
-    auto c = new XClient { .frame = frame, .child = w, .desktop = getprop<unsigned int>(w, "_NET_WM_DESKTOP", current_desktop) };
-    auto s = current_screen();
-    c->width = s->width / 3;
-    c->height = s->height / 3;
-    auto p = pointer();
-    c->x = p.x - c->width / 2;
-    c->y = p.y - c->height / 2;
-    c->right = c->x + c->width;
-    c->bottom = c->y + c->height;
-    c->mapped = false;
-    XSetWindowBorder(dpy, frame, BlackPixel(dpy, 0));
-    XAddToSaveSet(dpy, w);
-    XReparentWindow(dpy, w, frame, 4, HeadlineHeight);
-    int num;
-    Atom *atoms = XListProperties(dpy, w, &num);
-    c->gc = XCreateGC(dpy, w, 0, 0);
-    //if (!fs) fs = XLoadQueryFont(dpy, "-*-profont-*-*-*-*-12-*-*-*-*-*-*-*");
-    if (!fs) fs = XLoadQueryFont(dpy, "-*-helvetica-medium-r-*-*-12-*-*-*-*-*-*-*");
-    XSetFont(dpy, c->gc, fs->fid);
-    XSelectInput(dpy, frame, ButtonPressMask | ExposureMask | EnterWindowMask | SubstructureNotifyMask | SubstructureRedirectMask);
-    XSelectInput(dpy, w, PropertyChangeMask | StructureNotifyMask);
-    c->undecorated = WindowType(w) == atom("_NET_WM_WINDOW_TYPE_DOCK");
-    ProcessHints(*c);
-    clients[frame] = clients[w] = c;
-    unfocus(*c);
-    set_desktop(*c, c->desktop);
-    return *c;
+    return XManageClient(prefetch(std::vector<Window>{w})[0]);
   } else if (focus) {
     return *focused;
   } else {
@@ -209,20 +270,13 @@ void update_name (XClient &client)
     client.title = "Untitled Window";
   }
   XDrawFrame(client, &client == focused);
+  bar_update();
 }
 
 void focus (XClient& client, Window window = None, bool lockx = false, bool locky = false)
 {
-  if (focused)
-    unfocus(*focused);
   if (&client) {
-    XWindowAttributes attr;
-    XGetWindowAttributes(dpy, client.frame, &attr);
-    if (attr.map_state != IsViewable) return;
-    XUngrabButton(dpy, 1, AnyModifier, client.frame);
-    XSetInputFocus(dpy, client.child, RevertToPointerRoot, CurrentTime);
-    focused = &client;
-    XDrawFrame(client, true);
+    if (!client.viewable) return;
     if (!lockx)
       cursor.x = client.cursor().x;
     //else
@@ -231,80 +285,62 @@ void focus (XClient& client, Window window = None, bool lockx = false, bool lock
       cursor.y = client.cursor().y;
     //else
     //  cursor.y = std::max(client.top, std::min(client.bottom, cursor.y));
+    if (&client == focused) {
+      ++stats.focus_skipped;
+      return;
+    }
+    if (focused)
+      unfocus(*focused);
+    backend->set_input_focus(client.child);
+    focused = &client;
+    unfocus_others();
+    select_monitor(client.monitor);
+    ewmh_set_active(client.child);
+    XDrawFrame(client, true);
+    ++stats.focus_changes;
+    mru_touch(client);
+    bar_update();
+    ping(client);
   } else if (window) {
-    XSetInputFocus(dpy, window, RevertToPointerRoot, CurrentTime);
+    if (focused)
+      unfocus(*focused);
+    backend->set_input_focus(window);
     focused = 0;
+    ewmh_set_active(None);
+    bar_update();
   }
 }
 
+void XSendConfigureNotify (Window w, int x, int y, int width, int height)
+{
+  backend->send_configure(w, x, y, width, height);
+}
+
 void move_resize (XClient& client, int x, int y, int width, int height)
 {
   if (auto s = client.fullscreen) {
-    x = s->x_org;
-    y = s->y_org;
-    width = s->width;
-    height = s->height;
-    if (client.undecorated) {
-      XMoveResizeWindow(dpy, client.frame, x, y, width, height);
-      XSetWindowBorderWidth(dpy, client.frame, 0);
-      XMoveResizeWindow(dpy, client.child, 0, 0, width, height);
-      XConfigureEvent ev = {
-        .type = ConfigureNotify,
-        .event = client.child,
-        .window = client.child,
-        .x = x,
-        .y = y,
-        .width = width,
-        .height = height
-      };
-      XSendEvent(dpy, client.child, False, StructureNotifyMask, (XEvent *) &ev);
-    } else {
-      XMoveResizeWindow(dpy, client.frame, x, y, width, height);
-      XSetWindowBorderWidth(dpy, client.frame, 0);
-      XMoveResizeWindow(dpy, client.child, BorderWidth, BorderWidth,
-                             width + BorderWidth * 2,
-                             height + HeadlineHeight + BorderWidth * 2);
-      XConfigureEvent ev = {
-        .type = ConfigureNotify,
-        .event = client.child,
-        .window = client.child,
-        .x = x + BorderWidth,
-        .y = y + BorderWidth + HeadlineHeight,
-        .width = width,
-        .height = height
-      };
-      XSendEvent(dpy, client.child, False, StructureNotifyMask, (XEvent *) &ev);
-    }
+    XSendConfigureNotify(client.child, s->x_org, s->y_org, s->width, s->height);
   } else {
     if (client.undecorated) {
-      XMoveResizeWindow(dpy, client.frame, x, y, width, height);
-      XSetWindowBorderWidth(dpy, client.frame, 0);
-      XMoveResizeWindow(dpy, client.child, 0, 0, width, height);
+      backend->move_resize_window(client.frame, x, y, width, height);
+      backend->set_border_width(client.frame, 0);
+      backend->move_resize_window(client.child, 0, 0, width, height);
     } else if (client.shaded) {
-      XMoveResizeWindow(dpy, client.frame, x, y,
-                        width + BorderWidth * 2,
-                        HeadlineHeight + BorderWidth);
-      XSetWindowBorderWidth(dpy, client.frame, 0);
-      XMoveResizeWindow(dpy, client.child, BorderWidth, HeadlineHeight + BorderWidth,
-                        width, height);
+      backend->move_resize_window(client.frame, x, y,
+                                  width + BorderWidth * 2,
+                                  HeadlineHeight + BorderWidth);
+      backend->set_border_width(client.frame, 0);
+      backend->move_resize_window(client.child, BorderWidth, HeadlineHeight + BorderWidth,
+                                  width, height);
     } else {
-      XMoveResizeWindow(dpy, client.frame, x, y,
-                        width + BorderWidth * 2,
-                        height + HeadlineHeight + BorderWidth * 2);
-      XSetWindowBorderWidth(dpy, client.frame, 0);
-      XMoveResizeWindow(dpy, client.child, BorderWidth, BorderWidth + HeadlineHeight,
-                        width, height);
+      backend->move_resize_window(client.frame, x, y,
+                                  width + BorderWidth * 2,
+                                  height + HeadlineHeight + BorderWidth * 2);
+      backend->set_border_width(client.frame, 0);
+      backend->move_resize_window(client.child, BorderWidth, BorderWidth + HeadlineHeight,
+                                  width, height);
     }
-    XConfigureEvent ev = {
-      .type = ConfigureNotify,
-      .event = client.child,
-      .window = client.child,
-      .x = x + BorderWidth,
-      .y = y + BorderWidth + HeadlineHeight,
-      .width = width,
-      .height = height
-    };
-    XSendEvent(dpy, client.child, False, StructureNotifyMask, (XEvent *) &ev);
+    XSendConfigureNotify(client.child, x + BorderWidth, y + BorderWidth + HeadlineHeight, width, height);
     client.x = x;
     client.y = y;
     client.width = width;
@@ -312,7 +348,14 @@ void move_resize (XClient& client, int x, int y, int width, int height)
     client.right = x + client.width;
     client.bottom = y + client.height;
     setprop(client.child, "_NET_FRAME_EXTENTS", (long[]){BorderWidth, BorderWidth, BorderWidth + HeadlineHeight, BorderWidth});
+    XDrawFrame(client, &client == focused);
+    if (&client == focused)
+      bar_update();
+    int monitor = find_screen(client.cursor().x, client.cursor().y) - screens;
+    if (monitor != client.monitor)
+      set_monitor(client, monitor);
   }
+  freespace_update(client);
 }
 
 void XSetWMState (XClient& client, int state)
@@ -323,35 +366,45 @@ void XSetWMState (XClient& client, int state)
                   PropModeReplace, (unsigned char *) data, 2);
 }
 
-bool overlap (int start1, int end1, int start2, int end2)
+void XSetNetWMState (XClient& client, const char *name, bool on)
 {
-  if (start2 >= start1 && start2 <= end1) return true;
-  if (end2 >= start1 && end2 <= end1) return true;
-  if (start1 >= start2 && start1 <= end2) return true;
-  if (end1 >= start2 && end1 <= end2) return true;
-  return false;
+  auto state = getlist(client.child, "_NET_WM_STATE");
+  long value = atom(name);
+  state.erase(std::remove(state.begin(), state.end(), value), state.end());
+  if (on) state.push_back(value);
+  setlist(client.child, "_NET_WM_STATE", "ATOM", state.data(), state.size());
 }
 
-void fill (XClient& client)
+void set_fullscreen (XClient& client, bool on, XineramaScreenInfo *s)
 {
-  int min_x = current_screen()->x_org;
-  int min_y = current_screen()->y_org;
-  int max_x = current_screen()->width + min_x;
-  int max_y = current_screen()->height + min_y;
-  for (auto i = clients.begin(); i != clients.end(); ++i) {
-    auto &c = *i->second;
-    if (!&c)
-      continue;
-    if (&c == &client || (c.desktop & client.desktop) == 0)
-      continue;
-    if (overlap(c.left, c.right, client.left, client.right)) {
-      if (c.top > client.bottom) max_y = std::min(max_y, c.top);
-      if (c.bottom < client.top) min_y = std::max(min_y, c.bottom);
-    }
-    if (overlap(c.top, c.bottom, client.top, client.bottom)) {
-      if (c.left > client.right) max_x = std::min(max_x, c.left);
-      if (c.right < client.left) min_x = std::max(min_x, c.right);
-    }
+  if (!&client || !!client.fullscreen == on) return;
+  if (on) {
+    if (!s) s = find_screen(client.cursor().x, client.cursor().y);
+    if (s - screens != client.monitor)
+      set_monitor(client, s - screens);
+    client.fullscreen = s;
+    stack_layer(client);
+    backend->set_border_width(client.frame, 0);
+    backend->move_resize_window(client.frame, s->x_org, s->y_org, s->width, s->height);
+    backend->move_resize_window(client.child, 0, 0, s->width, s->height);
+    XSendConfigureNotify(client.child, s->x_org, s->y_org, s->width, s->height);
+    freespace_update(client);
+    stack_raise(client);
+  } else {
+    client.fullscreen = 0;
+    stack_layer(client);
+    move_resize(client, client.x, client.y, client.width, client.height);
+    XDrawFrame(client, &client == focused);
+    restack();
   }
-  move_resize(client, min_x + 5, min_y + 5, max_x - min_x - 20, max_y - min_y - HeadlineHeight - 16);
+  XSetNetWMState(client, "_NET_WM_STATE_FULLSCREEN", on);
+}
+
+void set_above (XClient& client, bool on)
+{
+  if (!&client || client.above == on) return;
+  client.above = on;
+  stack_layer(client);
+  restack();
+  XSetNetWMState(client, "_NET_WM_STATE_ABOVE", on);
 }
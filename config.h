@@ -1,7 +1,8 @@
 
-const int BorderWidth = 5;
-const int HeadlineHeight = 20;
+int BorderWidth = 5;
+int HeadlineHeight = 20;
 const int ModMask = Mod4Mask;
+const int DesktopCount = 9;
 
 inline unsigned long rgb (unsigned char blue, unsigned char green, unsigned char red)
 {
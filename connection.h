@@ -0,0 +1,171 @@
+struct Connection
+{
+  Display *dpy;
+  Window root;
+  int screen_number, connection_index;
+  XineramaScreenInfo *screens;
+  int screen_count;
+  uint32_t current_desktop;
+  std::vector<uint32_t> monitor_desktops;
+  int current_monitor;
+  XWindowAttributes attr;
+  XButtonEvent start;
+  int hf, vf;
+  unsigned int active_frame_pixel, frame_text_pixel, inactive_frame_pixel, inactive_text_pixel;
+  std::string frame_colors;
+  XrmDatabase settings_db;
+  int BorderWidth, HeadlineHeight;
+  int hover_delay, sync_timeout, ping_timeout, kill_delay;
+  std::map<Window, XClient *> clients;
+  XClient *focused;
+  std::vector<Window> client_list, client_list_stacking;
+  Window active_window;
+  std::vector<XClient *> stack_order;
+  std::vector<Window> stacked_frames;
+  std::vector<Strut> struts, fixed_struts;
+  std::vector<FreeSpace> free_spaces;
+  std::vector<XClient *> mru_heads;
+  XClient *cycle_position;
+  bool cycling;
+  std::vector<Bar> bars;
+  std::vector<Window> bar_windows;
+  int sync_event_base, sync_error_base;
+  std::map<XSyncAlarm, XClient *> sync_alarms;
+  XPoint prefetched_pointer;
+  xcb_atom_t manage_atoms[ManageProperties];
+  std::map<int, GC> gcs;
+  Cursor cursors[XC_num_glyphs / 2];
+  XEventHandler event_handlers[128];
+  cursor_t cursor;
+};
+
+std::vector<Connection *> connections;
+
+void exchange (Connection& c)
+{
+  std::swap(c.dpy, ::dpy);
+  std::swap(c.root, ::root);
+  std::swap(c.screen_number, ::screen_number);
+  std::swap(c.connection_index, ::connection_index);
+  std::swap(c.screens, ::screens);
+  std::swap(c.screen_count, ::screen_count);
+  std::swap(c.current_desktop, ::current_desktop);
+  std::swap(c.monitor_desktops, ::monitor_desktops);
+  std::swap(c.current_monitor, ::current_monitor);
+  std::swap(c.attr, ::attr);
+  std::swap(c.start, ::start);
+  std::swap(c.hf, ::hf);
+  std::swap(c.vf, ::vf);
+  std::swap(c.active_frame_pixel, ::active_frame_pixel);
+  std::swap(c.frame_text_pixel, ::frame_text_pixel);
+  std::swap(c.inactive_frame_pixel, ::inactive_frame_pixel);
+  std::swap(c.inactive_text_pixel, ::inactive_text_pixel);
+  std::swap(c.frame_colors, ::frame_colors);
+  std::swap(c.settings_db, ::settings_db);
+  std::swap(c.BorderWidth, ::BorderWidth);
+  std::swap(c.HeadlineHeight, ::HeadlineHeight);
+  std::swap(c.hover_delay, ::hover_delay);
+  std::swap(c.sync_timeout, ::sync_timeout);
+  std::swap(c.ping_timeout, ::ping_timeout);
+  std::swap(c.kill_delay, ::kill_delay);
+  std::swap(c.clients, ::clients);
+  std::swap(c.focused, ::focused);
+  std::swap(c.client_list, ::client_list);
+  std::swap(c.client_list_stacking, ::client_list_stacking);
+  std::swap(c.active_window, ::active_window);
+  std::swap(c.stack_order, ::stack_order);
+  std::swap(c.stacked_frames, ::stacked_frames);
+  std::swap(c.struts, ::struts);
+  std::swap(c.fixed_struts, ::fixed_struts);
+  std::swap(c.free_spaces, ::free_spaces);
+  std::swap(c.mru_heads, ::mru_heads);
+  std::swap(c.cycle_position, ::cycle_position);
+  std::swap(c.cycling, ::cycling);
+  std::swap(c.bars, ::bars);
+  std::swap(c.bar_windows, ::bar_windows);
+  std::swap(c.sync_event_base, ::sync_event_base);
+  std::swap(c.sync_error_base, ::sync_error_base);
+  std::swap(c.sync_alarms, ::sync_alarms);
+  std::swap(c.prefetched_pointer, ::prefetched_pointer);
+  std::swap(c.manage_atoms, ::manage_atoms);
+  std::swap(c.gcs, ::gcs);
+  std::swap(c.cursors, ::cursors);
+  std::swap(c.event_handlers, ::event_handlers);
+  std::swap(c.cursor, ::cursor);
+}
+
+void activate (Connection *c)
+{
+  if (!c || c == active_connection) return;
+  if (active_connection)
+    exchange(*active_connection);
+  exchange(*c);
+  active_connection = c;
+}
+
+void each_connection (std::function<void ()> fn)
+{
+  for (auto c : connections) {
+    activate(c);
+    fn();
+  }
+}
+
+void unfocus_others ()
+{
+  for (auto c : connections) {
+    if (c == active_connection || !c->focused) continue;
+    add_timer(0, [] {
+      if (!focused) return;
+      unfocus(*focused);
+      focused = 0;
+      ewmh_set_active(None);
+      bar_update();
+    }, c);
+  }
+}
+
+void open_connection (Display *d, int screen)
+{
+  auto c = new Connection();
+  c->dpy = d;
+  c->screen_number = screen;
+  c->connection_index = connections.size();
+  c->root = RootWindow(d, screen);
+  c->current_desktop = 1;
+  c->active_window = ~0UL;
+  c->BorderWidth = BorderWidth;
+  c->HeadlineHeight = HeadlineHeight;
+  if (ScreenCount(d) == 1)
+    c->screens = XineramaQueryScreens(d, &c->screen_count);
+  if (!c->screens) {
+    c->screens = new XineramaScreenInfo[1];
+    c->screens->x_org = 0;
+    c->screens->y_org = 0;
+    c->screens->width = DisplayWidth(d, screen);
+    c->screens->height = DisplayHeight(d, screen);
+    c->screen_count = 1;
+  }
+  c->monitor_desktops.assign(c->screen_count, 1);
+  c->mru_heads.assign(c->screen_count * DesktopCount, 0);
+  XSynchronize(d, True);
+  connections.push_back(c);
+  activate(c);
+}
+
+void open_display (const char *name)
+{
+  auto d = XOpenDisplay(name);
+  if (!d)
+    err(1, "failed to open %s", XDisplayName(name));
+  auto spec = strrchr(XDisplayName(name), ':');
+  bool single = spec && strchr(spec, '.');
+  int count = ScreenCount(d), first = DefaultScreen(d);
+  for (int s = 0; s < count; ++s) {
+    if (single && s != first) continue;
+    if (!d && !(d = XOpenDisplay(name)))
+      err(1, "failed to open %s", XDisplayName(name));
+    open_connection(d, s);
+    d = 0;
+  }
+}
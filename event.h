@@ -1,19 +1,70 @@
 
 typedef void (* XEventHandler)(XEvent& event);
-XEventHandler event_handlers[LASTEvent];
+XEventHandler event_handlers[128];
 
 template<typename T>
 inline void XSetEventHandler(int event, void (* fn) (T& event)) {
   event_handlers[event] = reinterpret_cast<XEventHandler>(fn);
 }
 
+std::map<int, std::function<void ()>> watchers;
+
+void watch_fd (int fd, std::function<void ()> fn)
+{
+  watchers[fd] = fn;
+}
+
+void reload_settings ();
+void load_refresh ();
+void load_heaviest ();
+
+void dump_stats ()
+{
+  fprintf(stderr, "focus changes %ld, skipped %ld, hover cancelled %ld, redraws avoided %ld, sync timeouts %ld\n",
+          stats.focus_changes, stats.focus_skipped, stats.hover_cancelled, stats.redraws_avoided, stats.sync_timeouts);
+  fprintf(stderr, "configure requests %ld, unchanged %ld\n", stats.configure_requests, stats.configure_unchanged);
+  for (auto i = clients.begin(); i != clients.end(); ++i)
+    if (i->first == i->second->frame && i->second->configure_requests)
+      fprintf(stderr, "  0x%lx %s: %ld configure requests\n", i->second->child,
+              i->second->wm_class.c_str(), i->second->configure_requests);
+  dump_resources();
+}
+
 void XEventLoop ()
 {
   for (;;) {
-    XEvent event;
-    XNextEvent(dpy, &event);
-    if (auto fn = event_handlers[event.type])
-      fn(event);
+    auto timeout = run_timers();
+    if (dump_requested) {
+      dump_requested = 0;
+      dump_stats();
+    }
+    if (reload_requested) {
+      reload_requested = 0;
+      reload_settings();
+    }
+    bool pending = false;
+    each_connection([&pending] {
+      if (!XPending(dpy)) return;
+      pending = true;
+      XEvent event;
+      XNextEvent(dpy, &event);
+      if (auto fn = event_handlers[event.type])
+        fn(event);
+    });
+    if (pending) continue;
+    std::vector<pollfd> fds;
+    each_connection([&fds] { fds.push_back(pollfd { ConnectionNumber(dpy), POLLIN }); });
+    auto displays = fds.size();
+    for (auto &w : watchers)
+      fds.push_back(pollfd { w.first, POLLIN });
+    poll(fds.data(), fds.size(), timeout);
+    for (size_t i = displays; i < fds.size(); ++i) {
+      auto w = watchers.find(fds[i].fd);
+      if (fds[i].revents && w != watchers.end()) {
+        auto fn = w->second;
+        fn();
+      }
+    }
   }
 }
 
@@ -31,14 +82,19 @@ void button_press (XButtonPressedEvent& event)
     }
     XGrabPointer(dpy, win, True,
                 ButtonReleaseMask | PointerMotionMask, GrabModeAsync,
-                GrabModeAsync, root, XCreateFontCursor(dpy, XC_fleur),
+                GrabModeAsync, root, XCursor(XC_fleur),
                 event.time);
     start = event;
   } else if (event.button == 2) {
-    if (event.state & ShiftMask) {
-      XLowerWindow(dpy, win);
+    if (!&client) {
+      if (event.state & ShiftMask)
+        XLowerWindow(dpy, win);
+      else
+        XRaiseWindow(dpy, win);
+    } else if (event.state & ShiftMask) {
+      stack_lower(client);
     } else {
-      XRaiseWindow(dpy, win);
+      stack_raise(client);
     }
   } else if (event.button == 3) {
     XGetWindowAttributes(dpy, win, &attr);
@@ -57,14 +113,14 @@ void button_press (XButtonPressedEvent& event)
     start.y = start.y_root;
     XGrabPointer(dpy, win, True,
                 ButtonReleaseMask | PointerMotionMask, GrabModeAsync,
-                GrabModeAsync, root, XCreateFontCursor(dpy, cursor),
+                GrabModeAsync, root, XCursor(cursor),
                 event.time);
   } else if (event.button == 4) {
     if (&client)
-      XLowerWindow(dpy, client.frame);
+      stack_lower(client);
   } else if (event.button == 5) {
     if (&client)
-      XRaiseWindow(dpy, client.frame);
+      stack_raise(client);
   }
 }
 
@@ -90,7 +146,7 @@ void motion (XMotionEvent& event)
     if (vf < 0) dh -= dy;
     else if (vf > 0) dh = dy, dy = 0;
     else dy = 0;
-    move_resize(client, attr.x + dx, attr.y + dy, std::max(HeadlineHeight, attr.width + dw), std::max(HeadlineHeight, attr.height + dh));
+    sync_resize(client, attr.x + dx, attr.y + dy, std::max(HeadlineHeight, attr.width + dw), std::max(HeadlineHeight, attr.height + dh));
   }
 }
 
@@ -103,34 +159,82 @@ void button_release (XButtonReleasedEvent& event)
 
 void configure (XConfigureRequestEvent& event)
 {
-  auto &client = XFindClient(event.window, True);
-  if (event.value_mask & CWX) client.x = event.x;
-  if (event.value_mask & CWY) client.y = event.y;
-  if (event.value_mask & CWX && event.value_mask & CWY) {
-    auto s = find_screen(client.x, client.y);
-    client.x -= s->x_org;
-    client.y -= s->y_org;
-    s = current_screen();
-    client.x += s->x_org;
-    client.y += s->y_org;
-    printf("%dx%d+%d+%d\n", client.width, client.height, client.x, client.y);
+  auto &client = XFindClient(event.window, False);
+  if (!&client) {
+    XWindowChanges wc;
+    wc.x = event.x;
+    wc.y = event.y;
+    wc.width = event.width;
+    wc.height = event.height;
+    wc.border_width = event.border_width;
+    wc.sibling = event.above;
+    wc.stack_mode = event.detail;
+    XConfigureWindow(dpy, event.window, event.value_mask, &wc);
+    return;
+  }
+  ++client.configure_requests;
+  ++stats.configure_requests;
+  int x = client.x, y = client.y, width = client.width, height = client.height;
+  bool offset = !client.undecorated && client.hints.flags & PWinGravity && client.hints.win_gravity == StaticGravity;
+  if (event.value_mask & CWX) x = offset ? event.x - BorderWidth : event.x;
+  if (event.value_mask & CWY) y = offset ? event.y - BorderWidth - HeadlineHeight : event.y;
+  if (event.value_mask & CWWidth) width = event.width;
+  if (event.value_mask & CWHeight) height = event.height;
+  constrain(client, width, height);
+  log_message(LogLayout, LogDebug, "configure 0x%lx to %ldx%ld (request %ld)", client.child,
+              width, height, client.configure_requests);
+  if (client.fullscreen || (x == client.x && y == client.y && width == client.width && height == client.height)) {
+    ++stats.configure_unchanged;
+    if (auto s = client.fullscreen)
+      XSendConfigureNotify(client.child, s->x_org, s->y_org, s->width, s->height);
+    else if (client.undecorated)
+      XSendConfigureNotify(client.child, x, y, width, height);
+    else
+      XSendConfigureNotify(client.child, x + BorderWidth, y + BorderWidth + HeadlineHeight, width, height);
+  } else {
+    move_resize(client, x, y, width, height);
+  }
+  if (!(event.value_mask & CWStackMode)) return;
+  // TopIf, BottomIf and Opposite depend on occlusion and are not honoured.
+  if (event.detail != Above && event.detail != Below) return;
+  if (event.value_mask & CWSibling) {
+    auto &sibling = XFindClient(event.above, False);
+    if (&sibling)
+      stack_place(client, sibling, event.detail == Above);
+  } else if (event.detail == Above) {
+    stack_raise(client);
+  } else {
+    stack_lower(client);
   }
-  if (event.value_mask & CWWidth) client.width = event.width;
-  if (event.value_mask & CWHeight) client.height = event.height;
-  move_resize(client, client.x, client.y, client.width, client.height);
-  XSetWindowBorderWidth(dpy, client.child, 0);
 }
 
 void map (XMapRequestEvent& event)
 {
+  auto requested = now_us();
+  bool managed = IsClient(event.window);
   auto &client = XFindClient(event.window, True);
-  move_resize(client, client.x, client.y, client.width, client.height + 15);
+  move_resize(client, client.x, client.y, client.width, client.height);
+  if (managed) {
+    auto state = getlist(client.child, "_NET_WM_STATE");
+    if (std::count(state.begin(), state.end(), (long) atom("_NET_WM_STATE_FULLSCREEN")))
+      set_fullscreen(client, true);
+  }
+  client.map_requested = requested;
+  XSelectInput(dpy, client.child, PropertyChangeMask | StructureNotifyMask | ExposureMask);
   XMapWindow(dpy, client.child);
-  XMapWindow(dpy, client.frame);
+  if (client.desktop & monitor_desktops[client.monitor]) {
+    XMapWindow(dpy, client.frame);
+    client.viewable = true;
+  }
   XSetWMState(client, 1);
   XSetWindowBorderWidth(dpy, client.child, 0);
-  update_name(client);
+  if (managed)
+    update_name(client);
   client.mapped = true;
+  mru_touch(client);
+  freespace_update(client);
+  ewmh_add_client(client.child);
+  restack();
 }
 
 void destroy (XDestroyWindowEvent& event)
@@ -142,36 +246,101 @@ void unmap (XUnmapEvent& event)
 {
   auto &client = XFindClient(event.window, False);
   if (&client) {
+    if (client.mapped)
+      remember(client.wm_class, client.x, client.y, client.width, client.height, client.desktop);
     XUnmapWindow(dpy, client.frame);
+    client.viewable = false;
     XSetWMState(client, 0);
-    if (&client == focused)
-      focused = 0;
     client.mapped = false;
+    mru_remove(client);
+    freespace_update(client);
+    if (&client == focused) {
+      focused = 0;
+      focus_fallback();
+      bar_update();
+    }
+    ewmh_remove_client(client.child);
+    restack();
   }
 }
 
+Timer hover_timer;
+
 void enter (XEnterWindowEvent& event)
 {
   auto &client = XFindClient(event.window, false);
+  if (focused && focused->fullscreen && &client != focused
+      && find_screen(event.x_root, event.y_root) == focused->fullscreen)
+    return;
+  if (hover_timer) {
+    cancel_timer(hover_timer);
+    ++stats.hover_cancelled;
+  }
+  if (hover_delay && &client && &client != focused) {
+    auto child = client.child;
+    hover_timer = add_timer(hover_delay * 1000L, [child] {
+      hover_timer = 0;
+      auto &client = XFindClient(child, False);
+      if (&client)
+        focus(client);
+    });
+    return;
+  }
   focus(client, event.window);
 }
 
 void message (XClientMessageEvent& event)
 {
+  if (event.message_type == atom("WM_PROTOCOLS") && (Atom) event.data.l[0] == atom("_NET_WM_PING")) {
+    pong(event.data.l[2]);
+    return;
+  }
+  auto &client = XFindClient(event.window, False);
+  if (!&client) return;
+  if (event.message_type == atom("_NET_WM_STATE")) {
+    for (int i = 1; i <= 2; ++i) {
+      auto action = event.data.l[0];
+      if (event.data.l[i] == atom("_NET_WM_STATE_FULLSCREEN"))
+        set_fullscreen(client, action == 2 ? !client.fullscreen : action == 1);
+      else if (event.data.l[i] == atom("_NET_WM_STATE_ABOVE"))
+        set_above(client, action == 2 ? !client.above : action == 1);
+    }
+  } else if (event.message_type == atom("_NET_ACTIVE_WINDOW")) {
+    if (client.desktop && (client.desktop & monitor_desktops[client.monitor]) == 0)
+      set_desktop(client.monitor, client.desktop & -client.desktop);
+    stack_raise(client);
+    focus(client);
+  }
 }
 
 void expose (XExposeEvent& event)
 {
   auto &client = XFindClient(event.window, False);
-  if (&client)
-    XDrawFrame(client, &client == focused);
+  if (!&client || event.window != client.child || !client.map_requested) return;
+  client.map_latency = now_us() - client.map_requested;
+  client.map_requested = 0;
+  XSelectInput(dpy, client.child, PropertyChangeMask | StructureNotifyMask);
+  setprop(client.child, "_ADMIRAL_MAP_LATENCY", (long[]){client.map_latency});
 }
 
 void property (XPropertyEvent& event)
 {
+  if (event.window == root) {
+    if (event.atom == XA_RESOURCE_MANAGER)
+      reload_settings();
+    return;
+  }
   auto &client = XFindClient(event.window, False);
-  auto prop = XGetAtomName(dpy, event.atom);
   if (!&client) return;
+  if (event.atom == atom("WM_PROTOCOLS")) {
+    client.protocols = getlist(client.child, "WM_PROTOCOLS");
+    return;
+  }
+  if (event.atom == atom("_NET_WM_STRUT_PARTIAL") || event.atom == atom("_NET_WM_STRUT")) {
+    client.strut = strut_values(getlist(client.child, "_NET_WM_STRUT_PARTIAL"), getlist(client.child, "_NET_WM_STRUT"));
+    update_struts();
+    return;
+  }
   update_name(client);
 }
 
@@ -183,7 +352,7 @@ void focus_towards (int x, int y)
     auto &client = *i->second;
     auto ccursor = client.cursor();
     if (i->first == client.child) continue;
-    if ((client.desktop & current_desktop) == 0) continue;
+    if ((client.desktop & monitor_desktops[client.monitor]) == 0) continue;
     if (focused == &client) continue;
     if (!client.mapped) continue;
     if (focused && x) {
@@ -206,9 +375,9 @@ void focus_towards (int x, int y)
     }
   }
   if (nearest_client) {
-    printf("%li\n", nearest_distance);
+    log_message(LogFocus, LogDebug, "nearest distance %ld", nearest_distance);
     focus(*nearest_client, nearest_client->child, y*y, x*x);
-    XRaiseWindow(dpy, nearest_client->frame);
+    stack_raise(*nearest_client);
   }
 }
 
@@ -290,49 +459,39 @@ void key_press (XKeyPressedEvent& event)
   } else if (match_key(event, "M-Return")) {
     spawn(getenv("TERMINAL", "gnome-terminal"));
   } else if (match_key(event, "M-c")) {
-    XDeleteClient(client.child);
+    if (&client)
+      close_client(client);
   } else if (match_key(event, "M-S-c")) {
-    XDestroyClient(client.child);
+    if (&client)
+      XDestroyClient(client.child);
   } else if (match_key(event, "M-q")) {
-    execlp(command, command, 0);
+    execvp(command, arguments);
   } else if (match_key(event, "M-s")) {
     client.shaded = !client.shaded;
     move_resize(client, client.x, client.y, client.width, client.height);
   } else if (match_key(event, "M-f")) {
-    client.undecorated = false;
-    current_screen();
-    if (client.fullscreen) {
-      client.fullscreen = 0;
-    } else {
-      auto s = find_screen(event.x_root, event.y_root);
-      if (s) client.fullscreen = s;
-      client.undecorated = true;
-    }
-    move_resize(client, client.x, client.y, client.width, client.height);
+    if (&client)
+      set_fullscreen(client, !client.fullscreen, find_screen(event.x_root, event.y_root));
   } else if (match_key(event, "M-m")) {
     fill(client);
   } else if (match_key(event, "M-r")) {
     spawn("/home/nathan/admiral/libexec/run");
   } else if (match_key(event, "M-Prior")) {
-    XLowerWindow(dpy, event.subwindow);
+    if (&client)
+      stack_lower(client);
   } else if (match_key(event, "M-Next")) {
-    XRaiseWindow(dpy, event.subwindow);
+    if (&client)
+      stack_raise(client);
   } else if (match_key(event, "M-t")) {
     if (client.desktop == -1) {
-      set_desktop(client, current_desktop);
+      set_desktop(client, monitor_desktops[client.monitor]);
     } else {
       set_desktop(client, -1);
     }
   } else if (match_key(event, "M-comma")) {
-    current_desktop >>= 1;
-    if (current_desktop == 0)
-      current_desktop = 256;
-    set_desktop(current_desktop);
+    shift_desktop(-1);
   } else if (match_key(event, "M-period")) {
-    current_desktop <<= 1;
-    if (current_desktop == 512)
-      current_desktop = 1;
-    set_desktop(current_desktop);
+    shift_desktop(1);
   } else if (match_key(event, "M-Left")) {
     focus_towards(-1, 0);
   } else if (match_key(event, "M-Right")) {
@@ -341,13 +500,28 @@ void key_press (XKeyPressedEvent& event)
     focus_towards(0, -1);
   } else if (match_key(event, "M-Down")) {
     focus_towards(0, 1);
+  } else if (match_key(event, "M-l")) {
+    load_overlay = !load_overlay;
+    load_refresh();
+  } else if (match_key(event, "M-S-l")) {
+    load_heaviest();
+  } else if (match_key(event, "M-Tab")) {
+    cycle(false);
+  } else if (match_key(event, "M-S-Tab")) {
+    cycle(true);
   }
 }
 
+void key_release (XKeyReleasedEvent& event)
+{
+  auto sym = XLookupKeysym(&event, 0);
+  if (cycling && (sym == XK_Super_L || sym == XK_Super_R))
+    cycle_end();
+}
+
 int error (Display *dpy, XErrorEvent *error)
 {
-  char buff[80];
-  XGetErrorText(dpy, error->error_code, buff, 80);
-  fprintf(stderr, "%s\n", buff);
+  log_message(LogX, LogError, "error %ld on request %ld.%ld for 0x%lx", error->error_code,
+              error->request_code, error->minor_code, error->resourceid);
   return 0;
 }
@@ -0,0 +1,108 @@
+#include <vector>
+#include <algorithm>
+
+const char *ewmh_supported[] = {
+  "_NET_SUPPORTED",
+  "_NET_SUPPORTING_WM_CHECK",
+  "_NET_CLIENT_LIST",
+  "_NET_CLIENT_LIST_STACKING",
+  "_NET_ACTIVE_WINDOW",
+  "_NET_NUMBER_OF_DESKTOPS",
+  "_NET_CURRENT_DESKTOP",
+  "_NET_WORKAREA",
+  "_NET_WM_DESKTOP",
+  "_NET_FRAME_EXTENTS",
+  "_NET_WM_STATE",
+  "_NET_WM_STATE_FULLSCREEN",
+  "_NET_WM_STATE_ABOVE",
+  "_NET_WM_SYNC_REQUEST",
+  "_NET_WM_SYNC_REQUEST_COUNTER",
+  "_NET_WM_PING",
+  "_NET_WM_PID",
+};
+
+std::vector<Window> client_list, client_list_stacking;
+Window active_window = ~0UL;
+
+void ewmh_set_workarea (int x, int y, int width, int height)
+{
+  long area[DesktopCount * 4];
+  for (int i = 0; i < DesktopCount; ++i) {
+    area[i * 4 + 0] = x;
+    area[i * 4 + 1] = y;
+    area[i * 4 + 2] = width;
+    area[i * 4 + 3] = height;
+  }
+  setprop(root, "_NET_WORKAREA", area);
+}
+
+uint32_t desktop_mask (unsigned long index)
+{
+  if (index == 0xFFFFFFFF) return -1;
+  return index < (unsigned long) DesktopCount ? 1 << index : 1;
+}
+
+long ewmh_desktop (uint32_t mask)
+{
+  if ((mask & ((1 << DesktopCount) - 1)) == (1 << DesktopCount) - 1) return 0xFFFFFFFF;
+  return mask ? __builtin_ctz(mask) : 0;
+}
+
+void ewmh_set_desktop (Window w, uint32_t mask)
+{
+  setprop(w, "_NET_WM_DESKTOP", (long[]){ewmh_desktop(mask)});
+}
+
+void ewmh_set_current_desktop (uint32_t mask)
+{
+  setprop(root, "_NET_CURRENT_DESKTOP", (long[]){ewmh_desktop(mask)});
+}
+
+void ewmh_init ()
+{
+  Atom atoms[sizeof(ewmh_supported) / sizeof(*ewmh_supported)];
+  int count = 0;
+  for (auto name : ewmh_supported)
+    atoms[count++] = atom(name);
+  setlist(root, "_NET_SUPPORTED", "ATOM", atoms, count);
+  Window check = XCreateSimpleWindow(dpy, root, -1, -1, 1, 1, 0, 0, 0);
+  setlist(root, "_NET_SUPPORTING_WM_CHECK", "WINDOW", &check, 1);
+  setlist(check, "_NET_SUPPORTING_WM_CHECK", "WINDOW", &check, 1);
+  XChangeProperty(dpy, check, atom("_NET_WM_NAME"), atom("UTF8_STRING"), 8,
+                  PropModeReplace, (unsigned char *) "admiral", 7);
+  setprop(root, "_NET_NUMBER_OF_DESKTOPS", (long[]){DesktopCount});
+  ewmh_set_workarea(0, 0, DisplayWidth(dpy, screen_number), DisplayHeight(dpy, screen_number));
+  setlist(root, "_NET_CLIENT_LIST", "WINDOW", 0, 0);
+  setlist(root, "_NET_CLIENT_LIST_STACKING", "WINDOW", 0, 0);
+}
+
+void ewmh_set_active (Window w)
+{
+  if (w == active_window) return;
+  active_window = w;
+  setlist(root, "_NET_ACTIVE_WINDOW", "WINDOW", &w, 1);
+}
+
+void ewmh_add_client (Window w)
+{
+  if (std::find(client_list.begin(), client_list.end(), w) != client_list.end()) return;
+  client_list.push_back(w);
+  setlist(root, "_NET_CLIENT_LIST", "WINDOW", &w, 1, PropModeAppend);
+}
+
+void ewmh_remove_client (Window w)
+{
+  auto i = std::find(client_list.begin(), client_list.end(), w);
+  if (i == client_list.end()) return;
+  client_list.erase(i);
+  setlist(root, "_NET_CLIENT_LIST", "WINDOW", client_list.data(), client_list.size());
+  if (w == active_window)
+    ewmh_set_active(None);
+}
+
+void ewmh_set_stacking (const std::vector<Window>& stacking)
+{
+  if (stacking == client_list_stacking) return;
+  client_list_stacking = stacking;
+  setlist(root, "_NET_CLIENT_LIST_STACKING", "WINDOW", stacking.data(), stacking.size());
+}
@@ -0,0 +1,213 @@
+struct Area
+{
+  int left, top, right, bottom;
+  long size () const { return (long) (right - left) * (bottom - top); }
+  bool intersects (const Area& o) const {
+    return left < o.right && o.left < right && top < o.bottom && o.top < bottom;
+  }
+  bool contains (const Area& o) const {
+    return left <= o.left && top <= o.top && right >= o.right && bottom >= o.bottom;
+  }
+  bool operator== (const Area& o) const {
+    return left == o.left && top == o.top && right == o.right && bottom == o.bottom;
+  }
+};
+
+enum Edge { EdgeLeft, EdgeRight, EdgeTop, EdgeBottom };
+
+struct Strut
+{
+  Edge edge;
+  Area area;
+};
+
+struct FreeSpace
+{
+  bool valid;
+  Area work;
+  std::map<XClient *, Area> obstacles;
+  std::vector<Area> free;
+};
+
+std::vector<Strut> struts, fixed_struts;
+std::vector<FreeSpace> free_spaces;
+
+Area screen_area (XineramaScreenInfo *s)
+{
+  return Area { s->x_org, s->y_org, s->x_org + s->width, s->y_org + s->height };
+}
+
+Area root_area ()
+{
+  Area a = screen_area(&screens[0]);
+  for (int i = 1; i < screen_count; ++i) {
+    auto s = screen_area(&screens[i]);
+    a = Area { std::min(a.left, s.left), std::min(a.top, s.top),
+               std::max(a.right, s.right), std::max(a.bottom, s.bottom) };
+  }
+  return a;
+}
+
+Area frame_area (XClient& client)
+{
+  if (client.undecorated)
+    return Area { client.x, client.y, client.x + client.width, client.y + client.height };
+  return Area { client.x, client.y, client.x + client.width + BorderWidth * 2,
+                client.y + (client.shaded ? 0 : client.height + BorderWidth) + HeadlineHeight + BorderWidth };
+}
+
+Area shrink (Area a)
+{
+  for (auto &s : struts) {
+    if (!a.intersects(s.area)) continue;
+    switch (s.edge) {
+      case EdgeLeft: a.left = std::max(a.left, s.area.right); break;
+      case EdgeRight: a.right = std::min(a.right, s.area.left); break;
+      case EdgeTop: a.top = std::max(a.top, s.area.bottom); break;
+      case EdgeBottom: a.bottom = std::min(a.bottom, s.area.top); break;
+    }
+  }
+  return a;
+}
+
+void subtract (std::vector<Area>& free, const Area& o)
+{
+  std::vector<Area> parts;
+  for (auto &f : free) {
+    if (!f.intersects(o)) {
+      parts.push_back(f);
+      continue;
+    }
+    if (o.left > f.left) parts.push_back(Area { f.left, f.top, o.left, f.bottom });
+    if (o.right < f.right) parts.push_back(Area { o.right, f.top, f.right, f.bottom });
+    if (o.top > f.top) parts.push_back(Area { f.left, f.top, f.right, o.top });
+    if (o.bottom < f.bottom) parts.push_back(Area { f.left, o.bottom, f.right, f.bottom });
+  }
+  free.clear();
+  for (size_t i = 0; i < parts.size(); ++i) {
+    bool maximal = true;
+    for (size_t j = 0; j < parts.size() && maximal; ++j)
+      if (i != j && parts[j].contains(parts[i]) && (!parts[i].contains(parts[j]) || j < i))
+        maximal = false;
+    if (maximal)
+      free.push_back(parts[i]);
+  }
+}
+
+bool obstacle (XClient& client)
+{
+  return IsClient(client.frame) && client.mapped && !client.fullscreen
+    && client.type != atom("_NET_WM_WINDOW_TYPE_DOCK")
+    && client.type != atom("_NET_WM_WINDOW_TYPE_DESKTOP");
+}
+
+FreeSpace& free_space (int screen, int desktop)
+{
+  free_spaces.resize(screen_count * DesktopCount);
+  auto &fs = free_spaces[screen * DesktopCount + desktop];
+  if (fs.valid) return fs;
+  fs.work = shrink(screen_area(&screens[screen]));
+  fs.free.assign(1, fs.work);
+  for (auto &o : fs.obstacles)
+    if (o.second.intersects(fs.work))
+      subtract(fs.free, o.second);
+  fs.valid = true;
+  return fs;
+}
+
+void update_struts ()
+{
+  auto root = root_area();
+  struts = fixed_struts;
+  for (auto i = clients.begin(); i != clients.end(); ++i) {
+    auto &c = *i->second;
+    if (i->first != c.frame || c.strut.size() < 12 || !c.mapped) continue;
+    if (c.type != atom("_NET_WM_WINDOW_TYPE_DOCK")) continue;
+    auto &s = c.strut;
+    if (s[0]) struts.push_back(Strut { EdgeLeft, Area { root.left, (int) s[4], root.left + (int) s[0], (int) s[5] + 1 } });
+    if (s[1]) struts.push_back(Strut { EdgeRight, Area { root.right - (int) s[1], (int) s[6], root.right, (int) s[7] + 1 } });
+    if (s[2]) struts.push_back(Strut { EdgeTop, Area { (int) s[8], root.top, (int) s[9] + 1, root.top + (int) s[2] } });
+    if (s[3]) struts.push_back(Strut { EdgeBottom, Area { (int) s[10], root.bottom - (int) s[3], (int) s[11] + 1, root.bottom } });
+  }
+  for (auto &fs : free_spaces)
+    fs.valid = false;
+  auto work = shrink(root);
+  ewmh_set_workarea(work.left, work.top, work.right - work.left, work.bottom - work.top);
+}
+
+void freespace_update (XClient& client)
+{
+  if (!client.strut.empty() && client.type == atom("_NET_WM_WINDOW_TYPE_DOCK")) {
+    update_struts();
+    return;
+  }
+  free_spaces.resize(screen_count * DesktopCount);
+  bool blocks = obstacle(client);
+  auto a = frame_area(client);
+  for (size_t i = 0; i < free_spaces.size(); ++i) {
+    auto &fs = free_spaces[i];
+    bool inside = blocks && client.desktop & 1 << i % DesktopCount
+      && a.intersects(screen_area(&screens[i / DesktopCount]));
+    auto o = fs.obstacles.find(&client);
+    if (o == fs.obstacles.end() && !inside) continue;
+    if (o != fs.obstacles.end() && inside && o->second == a) continue;
+    if (inside)
+      fs.obstacles[&client] = a;
+    else
+      fs.obstacles.erase(o);
+    fs.valid = false;
+  }
+}
+
+int desktop_index (uint32_t desktop, int monitor)
+{
+  if (desktop & monitor_desktops[monitor]) desktop &= monitor_desktops[monitor];
+  return desktop ? __builtin_ctz(desktop) : 0;
+}
+
+void find_space (XineramaScreenInfo *s, uint32_t desktop, Placement& placement)
+{
+  auto &fs = free_space(s - screens, desktop_index(desktop, s - screens));
+  int width = placement.width + BorderWidth * 2,
+      height = placement.height + HeadlineHeight + BorderWidth * 2;
+  long best = -1;
+  for (auto &f : fs.free) {
+    if (f.right - f.left < width || f.bottom - f.top < height) continue;
+    int x = std::max(f.left, std::min(f.right - width, placement.x)),
+        y = std::max(f.top, std::min(f.bottom - height, placement.y));
+    long dist = (long) (x - placement.x) * (x - placement.x) + (long) (y - placement.y) * (y - placement.y);
+    if (best < 0 || dist < best) {
+      best = dist;
+      placement.x = x;
+      placement.y = y;
+    }
+  }
+}
+
+void fill (XClient& client)
+{
+  auto s = find_screen(client.cursor().x, client.cursor().y);
+  free_spaces.resize(screen_count * DesktopCount);
+  auto &fs = free_spaces[(s - screens) * DesktopCount + desktop_index(client.desktop, s - screens)];
+  auto work = shrink(screen_area(s)), frame = frame_area(client), best = work;
+  frame.left = std::max(work.left, std::min(work.right - 1, frame.left));
+  frame.right = std::max(frame.left + 1, std::min(work.right, frame.right));
+  frame.top = std::max(work.top, std::min(work.bottom - 1, frame.top));
+  frame.bottom = std::max(frame.top + 1, std::min(work.bottom, frame.bottom));
+  for (auto &o : fs.obstacles) {
+    auto &a = o.second;
+    if (o.first == &client || !a.intersects(work)) continue;
+    bool across = a.left < frame.right && frame.left < a.right,
+         along = a.top < frame.bottom && frame.top < a.bottom;
+    if (across && along) continue;
+    if (across && a.bottom <= frame.top) best.top = std::max(best.top, a.bottom);
+    if (across && a.top >= frame.bottom) best.bottom = std::min(best.bottom, a.top);
+    if (along && a.right <= frame.left) best.left = std::max(best.left, a.right);
+    if (along && a.left >= frame.right) best.right = std::min(best.right, a.left);
+  }
+  if (client.undecorated)
+    move_resize(client, best.left, best.top, best.right - best.left, best.bottom - best.top);
+  else
+    move_resize(client, best.left, best.top, best.right - best.left - BorderWidth * 2,
+                best.bottom - best.top - HeadlineHeight - BorderWidth * 2);
+}
@@ -0,0 +1,109 @@
+#include <deque>
+
+const int LoadSamples = 4;
+
+std::deque<std::pair<Connection *, Window>> load_queue;
+Timer load_timer;
+long clock_ticks = sysconf(_SC_CLK_TCK), page_kb = sysconf(_SC_PAGESIZE) / 1024;
+
+bool load_sample (XClient& client)
+{
+  char path[64], buf[1024];
+  snprintf(path, sizeof(path), "/proc/%d/stat", client.pid);
+  auto f = fopen(path, "r");
+  if (!f) return false;
+  auto len = fread(buf, 1, sizeof(buf) - 1, f);
+  fclose(f);
+  buf[len] = 0;
+  auto p = strrchr(buf, ')');
+  unsigned long utime, stime;
+  if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2)
+    return false;
+  snprintf(path, sizeof(path), "/proc/%d/statm", client.pid);
+  long size, resident = 0;
+  if ((f = fopen(path, "r"))) {
+    if (fscanf(f, "%ld %ld", &size, &resident) != 2)
+      resident = 0;
+    fclose(f);
+  }
+  long now = now_us(), time = utime + stime;
+  if (client.sampled_at)
+    client.cpu = (time - client.cpu_time) * 100000000L / clock_ticks / std::max(1L, now - client.sampled_at);
+  client.cpu_time = time;
+  client.sampled_at = now;
+  client.rss = resident * page_kb;
+  return true;
+}
+
+void load_label (XClient& client)
+{
+  if (!client.load.empty() && std::abs(client.cpu - client.shown_cpu) < 5
+      && std::abs(client.rss - client.shown_rss) * 10 < client.shown_rss)
+    return;
+  client.shown_cpu = client.cpu;
+  client.shown_rss = client.rss;
+  char text[32];
+  snprintf(text, sizeof(text), "%d%% %ldM", client.cpu, client.rss / 1024);
+  client.load = text;
+  if (load_overlay)
+    XDrawFrame(client, &client == focused);
+}
+
+long load_delay ()
+{
+  return (load_overlay ? load_interval : load_interval * 4) * 1000L;
+}
+
+void load_tick ()
+{
+  load_timer = 0;
+  auto n = std::min(load_queue.size(), (size_t) LoadSamples);
+  while (n--) {
+    auto entry = load_queue.front();
+    load_queue.pop_front();
+    activate(entry.first);
+    auto &client = XFindClient(entry.second, False);
+    if (!&client || !load_sample(client)) continue;
+    load_label(client);
+    load_queue.push_back(entry);
+  }
+  if (!load_queue.empty())
+    load_timer = add_timer(load_delay(), load_tick);
+}
+
+void load_watch (XClient& client)
+{
+  if (client.pid <= 0) return;
+  load_queue.push_back(std::make_pair(active_connection, client.child));
+  if (!load_timer)
+    load_timer = add_timer(load_delay(), load_tick);
+}
+
+void load_refresh ()
+{
+  auto self = active_connection;
+  cancel_timer(load_timer);
+  if (!load_queue.empty())
+    load_timer = add_timer(load_delay(), load_tick);
+  each_connection([] {
+    for (auto i = clients.begin(); i != clients.end(); ++i)
+      if (i->first == i->second->frame)
+        XDrawFrame(*i->second, i->second == focused);
+  });
+  activate(self);
+}
+
+void load_heaviest ()
+{
+  XClient *heaviest = 0;
+  for (auto i = clients.begin(); i != clients.end(); ++i) {
+    auto c = i->second;
+    if (i->first != c->frame || !c->viewable || c->pid <= 0) continue;
+    if (!c->sampled_at && !load_sample(*c)) continue;
+    if (!heaviest || c->cpu > heaviest->cpu || (c->cpu == heaviest->cpu && c->rss > heaviest->rss))
+      heaviest = c;
+  }
+  if (!heaviest) return;
+  stack_raise(*heaviest);
+  focus(*heaviest);
+}
@@ -0,0 +1,89 @@
+#include <thread>
+#include <sys/eventfd.h>
+
+enum LogSubsystem { LogCore, LogEvent, LogFocus, LogLayout, LogRender, LogX, LogSubsystems };
+enum LogLevel { LogOff = -1, LogError, LogInfo, LogDebug };
+
+const char *log_subsystem_names[] = { "core", "event", "focus", "layout", "render", "x" };
+const char *log_level_names[] = { "error", "info", "debug" };
+
+struct LogRecord
+{
+  long time;
+  LogSubsystem subsystem;
+  LogLevel level;
+  const char *format;
+  long args[4];
+};
+
+std::atomic<int> log_levels[LogSubsystems];
+SpscQueue<LogRecord, 1024> log_queues[2];
+thread_local int log_queue_index;
+std::atomic<bool> log_sleeping;
+std::atomic<long> log_dropped;
+int log_wakeup = -1;
+
+void log_push (const LogRecord& record)
+{
+  if (!log_queues[log_queue_index].push(record)) {
+    ++log_dropped;
+    return;
+  }
+  uint64_t one = 1;
+  if (log_wakeup >= 0 && log_sleeping.exchange(false))
+    write(log_wakeup, &one, sizeof(one));
+}
+
+template<typename... Args>
+inline void log_message (LogSubsystem subsystem, LogLevel level, const char *format, Args... args)
+{
+  if (log_levels[subsystem].load(std::memory_order_relaxed) < level) return;
+  log_push(LogRecord { now_us(), subsystem, level, format, { (long) args... } });
+}
+
+LogLevel log_level (const char *name)
+{
+  for (int l = LogError; l <= LogDebug; ++l)
+    if (!strcmp(name, log_level_names[l]))
+      return (LogLevel) l;
+  return LogOff;
+}
+
+bool log_drain ()
+{
+  bool any = false;
+  LogRecord r;
+  for (auto &queue : log_queues) {
+    while (queue.pop(r)) {
+      any = true;
+      char message[256];
+      snprintf(message, sizeof(message), r.format, r.args[0], r.args[1], r.args[2], r.args[3]);
+      fprintf(stderr, "%ld.%03ld %s %s: %s\n", r.time / 1000000, r.time / 1000 % 1000,
+              log_subsystem_names[r.subsystem], log_level_names[r.level], message);
+    }
+  }
+  if (auto dropped = log_dropped.exchange(0))
+    fprintf(stderr, "log: dropped %ld records\n", dropped);
+  return any;
+}
+
+void log_loop ()
+{
+  for (;;) {
+    while (log_drain())
+      continue;
+    log_sleeping = true;
+    if (log_drain()) {
+      log_sleeping = false;
+      continue;
+    }
+    uint64_t n;
+    read(log_wakeup, &n, sizeof(n));
+  }
+}
+
+void log_init ()
+{
+  log_wakeup = eventfd(0, EFD_CLOEXEC);
+  std::thread(log_loop).detach();
+}
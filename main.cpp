@@ -1,71 +1,42 @@
-#include <X11/extensions/Xinerama.h>
-#include <X11/Xlib.h>
-#include <X11/Xutil.h>
-#include <X11/cursorfont.h>
-#include <stdio.h>
-#include <sys/types.h>
-#include <signal.h>
-#include <unistd.h>
-#include <stdlib.h>
-#include <iostream>
-#include <string.h>
-#include <map>
-#include <err.h>
+#include "admiral.h"
 
-#include "config.h"
-#include "variables.h"
-#include "x11.h"
-#include "client.h"
-#include "workspaces.h"
-#include "util.h"
-#include "event.h"
-
-int main (int argc, const char *argv[])
+void manage_screen ()
 {
-  command = argv[0];
-  if (!(dpy = XOpenDisplay(0)))
-    err(1, "failed to start");
-  screens = XineramaQueryScreens(dpy, &screen_count);
-  if (!screens) {
-    screens = new XineramaScreenInfo[1];
-    screens->x_org = 0;
-    screens->y_org = 0;
-    screens->width = WidthOfScreen(XDefaultScreenOfDisplay(dpy));
-    screens->height = HeightOfScreen(XDefaultScreenOfDisplay(dpy));
-  }
-  XSynchronize(dpy, True);
-  current_desktop = 1;
-  active_frame_pixel   = XMakeColor(dpy, XGetDefault(dpy, "admiral", "active-color", "rgb:f/4/2"));
-  frame_text_pixel     = XMakeColor(dpy, XGetDefault(dpy, "admiral", "text-color", "rgb:f/f/f"));
-  inactive_frame_pixel = XMakeColor(dpy, XGetDefault(dpy, "admiral", "inactive-color", "rgb:a/a/a"));
-  root = DefaultRootWindow(dpy);
-  Window *children, parent;
+  resources_init();
+  ewmh_init();
+  bar_init();
+  XPtr<Window> children;
+  Window parent;
   unsigned int nchildren;
-  current_desktop = getprop<long>(root, "_NET_CURRENT_DESKTOP", 1);
-  XQueryTree(dpy, root, &root, &parent, &children, &nchildren);
-  for (int j = 0; j < nchildren; j++) {
-    XWindowAttributes attr;
-    XGetWindowAttributes(dpy, children[j], &attr);
-    if (!attr.override_redirect && attr.map_state == IsViewable) {
-      auto &client = XFindClient(children[j], True);
+  current_desktop = desktop_mask(getprop<long>(root, "_NET_CURRENT_DESKTOP", 0));
+  auto saved = getlist(root, "_ADMIRAL_MONITOR_DESKTOPS");
+  monitor_desktops.assign(screen_count, current_desktop);
+  for (size_t i = 0; i < saved.size() && i < monitor_desktops.size(); ++i)
+    if (saved[i])
+      monitor_desktops[i] = saved[i];
+  XQueryTree(dpy, root, &root, &parent, children.out(), &nchildren);
+  for (auto &info : prefetch(std::vector<Window>(children.get(), children.get() + nchildren))) {
+    if (!info.override_redirect && info.viewable) {
+      auto &client = XManageClient(info);
       client.mapped = true;
-      update_name(client);
+      mru_touch(client);
       if (!client.undecorated)
-        move_resize(client, attr.x - BorderWidth, attr.y - HeadlineHeight - BorderWidth, attr.width, attr.height);
+        move_resize(client, info.x - BorderWidth, info.y - HeadlineHeight - BorderWidth, info.width, info.height);
       else
-        move_resize(client, attr.x, attr.y, attr.width, attr.height);
-      auto num = getprop<long>(client.child, "_NET_WM_DESKTOP", -1);
+        move_resize(client, info.x, info.y, info.width, info.height);
       XSetWindowBorderWidth(dpy, client.child, 0);
       XMapWindow(dpy, client.child);
-      XMapWindow(dpy, client.frame);
-      set_desktop(client, num > -1 ? num : client.desktop);
-      XClearWindow(dpy, client.frame);
       XSetWMState(client, 1);
-      update_name(client);
+      ewmh_add_client(client.child);
     }
   }
-  XSelectInput(dpy, root, FocusChangeMask | ButtonPressMask | KeyPressMask | SubstructureRedirectMask);
-  XDefineCursor(dpy, root, XCreateFontCursor(dpy, XC_left_ptr));
+  update_struts();
+  for (int i = 0; i < screen_count; ++i)
+    set_desktop(i, monitor_desktops[i]);
+  select_monitor(current_screen() - screens);
+  restack();
+  XSelectInput(dpy, root, FocusChangeMask | ButtonPressMask | KeyPressMask | SubstructureRedirectMask | PropertyChangeMask);
+  XDefineCursor(dpy, root, XCursor(XC_left_ptr));
   XSetWindowBackground(dpy, root, XMakeColor(dpy, "rgb:4/6/8"));
   XClearWindow(dpy, root);
   grab_key(dpy, root, "M-Left");
@@ -74,6 +45,7 @@ int main (int argc, const char *argv[])
   grab_key(dpy, root, "M-Down");
   grab_key(dpy, root, "M-Return");
   grab_key(dpy, root, "M-c");
+  grab_key(dpy, root, "M-S-c");
   grab_key(dpy, root, "M-q");
   grab_key(dpy, root, "M-f");
   grab_key(dpy, root, "M-m");
@@ -121,6 +93,10 @@ int main (int argc, const char *argv[])
   grab_key(dpy, root, "M-t");
   grab_key(dpy, root, "M-comma");
   grab_key(dpy, root, "M-period");
+  grab_key(dpy, root, "M-Tab");
+  grab_key(dpy, root, "M-S-Tab");
+  grab_key(dpy, root, "M-l");
+  grab_key(dpy, root, "M-S-l");
   grab_button(dpy, root, "M-1");
   grab_button(dpy, root, "M-2");
   grab_button(dpy, root, "M-S-2");
@@ -128,6 +104,7 @@ int main (int argc, const char *argv[])
   grab_button(dpy, root, "M-4");
   grab_button(dpy, root, "M-5");
   XSetEventHandler(KeyPress, key_press);
+  XSetEventHandler(KeyRelease, key_release);
   XSetEventHandler(Expose, expose);
   XSetEventHandler(ButtonPress, button_press);
   XSetEventHandler(MotionNotify, motion);
@@ -139,7 +116,30 @@ int main (int argc, const char *argv[])
   XSetEventHandler(EnterNotify, enter);
   XSetEventHandler(ClientMessage, message);
   XSetEventHandler(PropertyNotify, property);
+  if (sync_init())
+    XSetEventHandler(sync_event_base + XSyncAlarmNotify, sync_alarm);
+}
+
+int main (int argc, const char *argv[])
+{
+  command = argv[0];
+  arguments = (char **) argv;
+  log_init();
+  XInitThreads();
+  if (argc < 2)
+    open_display(0);
+  for (int i = 1; i < argc; ++i)
+    open_display(argv[i]);
+  settings_init();
+  render_init();
+  watch_fd(render_drained, render_resume);
+  rules_load();
+  layout_open();
+  bar_status_init();
+  each_connection(manage_screen);
   XSetErrorHandler(error);
+  signal(SIGUSR1, [] (int) { dump_requested = 1; });
+  signal(SIGHUP, [] (int) { reload_requested = 1; });
   XEventLoop();
   return 0;
 }
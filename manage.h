@@ -0,0 +1,199 @@
+#include <X11/Xlib-xcb.h>
+
+struct MotifWmHints {
+   unsigned long flags;
+   unsigned long functions;
+   unsigned long decorations;
+   long input_mode;
+   unsigned long status;
+};
+
+struct ManageInfo
+{
+  Window window;
+  bool viewable, override_redirect;
+  int x, y, width, height;
+  bool has_desktop;
+  uint32_t desktop;
+  Atom type;
+  Window transient_for;
+  XSizeHints hints;
+  bool has_motif;
+  MotifWmHints motif;
+  std::string title, instance, cls, role;
+  std::vector<long> state, protocols;
+  XID sync_counter;
+  pid_t pid;
+  std::string machine;
+  std::vector<long> strut;
+};
+
+enum ManageProperty { PDesktop, PType, PNormalHints, PMotifHints, PNetName, PName, PClass, PRole, PState, PTransientFor,
+                      PProtocols, PSyncCounter, PPid, PMachine,
+                      PStrutPartial, PStrut, ManageProperties };
+
+const char *manage_properties[] = {
+  "_NET_WM_DESKTOP", "_NET_WM_WINDOW_TYPE", "WM_NORMAL_HINTS", "_MOTIF_WM_HINTS",
+  "_NET_WM_NAME", "WM_NAME", "WM_CLASS", "WM_WINDOW_ROLE", "_NET_WM_STATE",
+  "WM_TRANSIENT_FOR", "WM_PROTOCOLS", "_NET_WM_SYNC_REQUEST_COUNTER", "_NET_WM_PID",
+  "WM_CLIENT_MACHINE", "_NET_WM_STRUT_PARTIAL", "_NET_WM_STRUT",
+};
+
+struct ManageCookies
+{
+  xcb_get_window_attributes_cookie_t attributes;
+  xcb_get_geometry_cookie_t geometry;
+  xcb_get_property_cookie_t properties[ManageProperties];
+};
+
+XPoint prefetched_pointer;
+xcb_atom_t manage_atoms[ManageProperties];
+
+inline bool has_value (xcb_get_property_reply_t *r)
+{
+  return r && r->type != XCB_NONE && xcb_get_property_value_length(r) > 0;
+}
+
+inline const uint32_t *values (xcb_get_property_reply_t *r, int& count)
+{
+  count = r && r->format == 32 ? xcb_get_property_value_length(r) / 4 : 0;
+  return count ? (const uint32_t *) xcb_get_property_value(r) : 0;
+}
+
+inline std::string string_value (xcb_get_property_reply_t *r)
+{
+  if (!has_value(r)) return "";
+  return std::string((const char *) xcb_get_property_value(r), xcb_get_property_value_length(r));
+}
+
+std::vector<long> strut_values (std::vector<long> partial, const std::vector<long>& full)
+{
+  if (partial.size() >= 12) return partial;
+  if (full.size() < 4) return std::vector<long>();
+  partial.assign(full.begin(), full.begin() + 4);
+  for (int i = 0; i < 4; ++i) {
+    partial.push_back(0);
+    partial.push_back(0xFFFF);
+  }
+  return partial;
+}
+
+void parse_size_hints (xcb_get_property_reply_t *r, XSizeHints& hints)
+{
+  long f[18] = {};
+  int count;
+  auto v = values(r, count);
+  for (int i = 0; i < count && i < 18; ++i)
+    f[i] = (int32_t) v[i];
+  hints.flags = f[0];
+  hints.x = f[1];
+  hints.y = f[2];
+  hints.width = f[3];
+  hints.height = f[4];
+  hints.min_width = f[5];
+  hints.min_height = f[6];
+  hints.max_width = f[7];
+  hints.max_height = f[8];
+  hints.width_inc = f[9];
+  hints.height_inc = f[10];
+  hints.min_aspect.x = f[11];
+  hints.min_aspect.y = f[12];
+  hints.max_aspect.x = f[13];
+  hints.max_aspect.y = f[14];
+  hints.base_width = f[15];
+  hints.base_height = f[16];
+  hints.win_gravity = f[17];
+  if (count < 18)
+    hints.flags &= ~(PBaseSize | PWinGravity);
+}
+
+std::vector<ManageInfo> prefetch (const std::vector<Window>& windows)
+{
+  auto &atoms = manage_atoms;
+  if (!atoms[0])
+    for (int p = 0; p < ManageProperties; ++p)
+      atoms[p] = atom(manage_properties[p]);
+  auto xc = XGetXCBConnection(dpy);
+  auto pointer_cookie = xcb_query_pointer(xc, root);
+  std::vector<ManageCookies> cookies(windows.size());
+  for (size_t i = 0; i < windows.size(); ++i) {
+    cookies[i].attributes = xcb_get_window_attributes(xc, windows[i]);
+    cookies[i].geometry = xcb_get_geometry(xc, windows[i]);
+    for (int p = 0; p < ManageProperties; ++p)
+      cookies[i].properties[p] = xcb_get_property(xc, 0, windows[i], atoms[p], XCB_GET_PROPERTY_TYPE_ANY, 0, 1024);
+  }
+  xcb_generic_error_t *e = 0;
+  if (auto r = xcb_query_pointer_reply(xc, pointer_cookie, &e)) {
+    prefetched_pointer = XPoint{ r->root_x, r->root_y };
+    free(r);
+  }
+  free(e);
+  std::vector<ManageInfo> infos(windows.size());
+  for (size_t i = 0; i < windows.size(); ++i) {
+    auto &info = infos[i];
+    info.window = windows[i];
+    if (auto r = xcb_get_window_attributes_reply(xc, cookies[i].attributes, &e)) {
+      info.viewable = r->map_state == XCB_MAP_STATE_VIEWABLE;
+      info.override_redirect = r->override_redirect;
+      free(r);
+    }
+    free(e), e = 0;
+    if (auto r = xcb_get_geometry_reply(xc, cookies[i].geometry, &e)) {
+      info.x = r->x;
+      info.y = r->y;
+      info.width = r->width;
+      info.height = r->height;
+      free(r);
+    }
+    free(e), e = 0;
+    xcb_get_property_reply_t *props[ManageProperties];
+    for (int p = 0; p < ManageProperties; ++p) {
+      props[p] = xcb_get_property_reply(xc, cookies[i].properties[p], &e);
+      free(e), e = 0;
+    }
+    int count;
+    auto desktop = values(props[PDesktop], count);
+    if ((info.has_desktop = count))
+      info.desktop = desktop_mask(desktop[0]);
+    auto type = values(props[PType], count);
+    info.type = count ? type[0] : atom("_NET_WM_WINDOW_TYPE_NORMAL");
+    parse_size_hints(props[PNormalHints], info.hints);
+    auto motif = values(props[PMotifHints], count);
+    if ((info.has_motif = count >= 3)) {
+      info.motif.flags = motif[0];
+      info.motif.functions = motif[1];
+      info.motif.decorations = motif[2];
+    }
+    if (has_value(props[PNetName]))
+      info.title = string_value(props[PNetName]);
+    else if (has_value(props[PName]))
+      info.title = string_value(props[PName]);
+    else
+      info.title = "Untitled Window";
+    auto wm_class = string_value(props[PClass]);
+    auto nul = wm_class.find('\0');
+    info.instance = wm_class.substr(0, nul);
+    if (nul != std::string::npos)
+      info.cls = wm_class.substr(nul + 1, wm_class.find('\0', nul + 1) - nul - 1);
+    info.role = string_value(props[PRole]);
+    auto state = values(props[PState], count);
+    info.state.assign(state, state + count);
+    auto transient_for = values(props[PTransientFor], count);
+    info.transient_for = count && transient_for[0] != info.window ? transient_for[0] : None;
+    auto protocols = values(props[PProtocols], count);
+    info.protocols.assign(protocols, protocols + count);
+    auto counter = values(props[PSyncCounter], count);
+    info.sync_counter = count && std::count(info.protocols.begin(), info.protocols.end(), (long) atom("_NET_WM_SYNC_REQUEST"))
+      ? counter[0] : None;
+    auto pid = values(props[PPid], count);
+    info.pid = count ? pid[0] : 0;
+    info.machine = string_value(props[PMachine]).c_str();
+    auto partial = values(props[PStrutPartial], count);
+    std::vector<long> strut_partial(partial, partial + count);
+    auto full = values(props[PStrut], count);
+    info.strut = strut_values(strut_partial, std::vector<long>(full, full + count));
+    for (auto r : props)
+      free(r);
+  }
+  return infos;
+}
@@ -0,0 +1,107 @@
+std::vector<XClient *> mru_heads;
+XClient *cycle_position;
+bool cycling;
+
+XClient *&mru_head (int monitor, int d)
+{
+  return mru_heads[monitor * DesktopCount + d];
+}
+
+void mru_unlink (XClient& client, int d)
+{
+  auto &link = client.mru[d];
+  if (!link.next) return;
+  if (link.next == &client) {
+    mru_head(client.monitor, d) = 0;
+  } else {
+    link.prev->mru[d].next = link.next;
+    link.next->mru[d].prev = link.prev;
+    if (mru_head(client.monitor, d) == &client)
+      mru_head(client.monitor, d) = link.next;
+  }
+  link.prev = link.next = 0;
+}
+
+void mru_push (XClient& client, int d)
+{
+  mru_unlink(client, d);
+  auto &link = client.mru[d];
+  auto &head = mru_head(client.monitor, d);
+  if (head) {
+    link.next = head;
+    link.prev = head->mru[d].prev;
+    link.prev->mru[d].next = &client;
+    head->mru[d].prev = &client;
+  } else {
+    link.prev = link.next = &client;
+  }
+  head = &client;
+}
+
+void mru_touch (XClient& client)
+{
+  if (!client.mapped) return;
+  for (int d = 0; d < DesktopCount; ++d)
+    if (client.desktop & 1 << d && !(cycling && client.mru[d].next))
+      mru_push(client, d);
+}
+
+void mru_remove (XClient& client)
+{
+  if (cycle_position == &client)
+    cycle_position = 0;
+  for (int d = 0; d < DesktopCount; ++d)
+    mru_unlink(client, d);
+}
+
+XClient *mru_first ()
+{
+  return current_desktop ? mru_head(current_monitor, __builtin_ctz(current_desktop)) : 0;
+}
+
+void focus_fallback ()
+{
+  if (focused && focused->viewable) return;
+  if (auto next = mru_first())
+    focus(*next);
+}
+
+void cycle_end ()
+{
+  if (!cycling) return;
+  cycling = false;
+  XUngrabKeyboard(dpy, CurrentTime);
+  if (focused)
+    mru_touch(*focused);
+  cycle_position = 0;
+}
+
+bool super_down ()
+{
+  char keys[32];
+  XQueryKeymap(dpy, keys);
+  for (auto sym : { XK_Super_L, XK_Super_R }) {
+    auto code = XKeysymToKeycode(dpy, sym);
+    if (code && keys[code / 8] & 1 << code % 8)
+      return true;
+  }
+  return false;
+}
+
+void cycle (bool backward)
+{
+  auto head = mru_first();
+  if (!head) return;
+  if (!cycling) {
+    cycle_position = focused == head ? head : 0;
+    cycling = XGrabKeyboard(dpy, root, True, GrabModeAsync, GrabModeAsync, CurrentTime) == GrabSuccess;
+  }
+  int d = __builtin_ctz(current_desktop);
+  auto next = !cycle_position ? head
+    : backward ? cycle_position->mru[d].prev : cycle_position->mru[d].next;
+  cycle_position = next;
+  stack_raise(*next);
+  focus(*next);
+  if (cycling && !super_down())
+    cycle_end();
+}
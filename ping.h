@@ -0,0 +1,59 @@
+void kill_client (XClient& client)
+{
+  if (client.pid > 0)
+    kill(client.pid, SIGKILL);
+  else
+    XKillClient(dpy, client.child);
+}
+
+void ping (XClient& client)
+{
+  if (client.ping_timer || !supports(client, "_NET_WM_PING")) return;
+  XClientMessageEvent cme = {};
+  cme.type = ClientMessage;
+  cme.window = client.child;
+  cme.message_type = atom("WM_PROTOCOLS");
+  cme.format = 32;
+  cme.data.l[0] = atom("_NET_WM_PING");
+  cme.data.l[1] = CurrentTime;
+  cme.data.l[2] = client.child;
+  XSendEvent(dpy, client.child, False, 0, (XEvent *) &cme);
+  auto child = client.child;
+  client.ping_timer = add_timer(ping_timeout * 1000L, [child] {
+    auto &client = XFindClient(child, False);
+    if (!&client) return;
+    client.ping_timer = 0;
+    client.hung = true;
+    XDrawFrame(client, &client == focused);
+  });
+}
+
+void pong (Window w)
+{
+  auto &client = XFindClient(w, False);
+  if (!&client) return;
+  cancel_timer(client.ping_timer);
+  if (client.hung) {
+    client.hung = false;
+    XDrawFrame(client, &client == focused);
+  }
+}
+
+void close_client (XClient& client)
+{
+  if (client.hung) {
+    kill_client(client);
+    return;
+  }
+  XDeleteClient(client);
+  ping(client);
+  if (client.kill_timer) return;
+  auto child = client.child;
+  client.kill_timer = add_timer(kill_delay * 1000L, [child] {
+    auto &client = XFindClient(child, False);
+    if (!&client) return;
+    client.kill_timer = 0;
+    if (client.hung || !supports(client, "_NET_WM_PING"))
+      kill_client(client);
+  });
+}
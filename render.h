@@ -0,0 +1,205 @@
+#include <thread>
+#include <deque>
+#include <sys/eventfd.h>
+#include <errno.h>
+
+struct FrameState
+{
+  Window frame;
+  int width, height;
+  bool shaded, active, forget;
+  std::string title, tag;
+  int border, headline;
+  unsigned long color, text;
+  int connection, screen;
+  bool operator == (const FrameState& o) const {
+    return frame == o.frame && width == o.width && height == o.height && shaded == o.shaded
+      && active == o.active && forget == o.forget && title == o.title && tag == o.tag
+      && border == o.border && headline == o.headline && color == o.color && text == o.text;
+  }
+};
+
+struct FrameBackground
+{
+  Pixmap pixmap;
+  FrameState state;
+};
+
+struct FrameCache
+{
+  FrameBackground backgrounds[2];
+  Pixmap installed;
+  TextCache title_text, tag_text;
+};
+
+Display *rdpy;
+GC render_gc;
+std::vector<Display *> render_displays;
+std::vector<GC> render_gcs;
+int render_wakeup, render_drained;
+std::atomic<bool> render_blocked;
+SpscQueue<const FrameState *, 1024> render_queue;
+std::deque<const FrameState *> render_backlog;
+std::unordered_map<Window, FrameCache> frame_caches;
+
+void XRenderFrame (FrameCache& cache, const FrameState& state, Drawable d)
+{
+  int w = state.width,
+      h = state.height,
+      t = state.border + state.headline - 1,
+      l = state.border - 1,
+      b = h - l,
+      r = w - l;
+  unsigned long color = state.color, tint = state.active ? 0x333333 : 0x111111;
+  XSetForeground(rdpy, render_gc, color);
+  XFillRectangle(rdpy, d, render_gc, 0, 0, w + 1, h + 1);
+  if (!state.shaded) {
+    XSetForeground(rdpy, render_gc, color - tint);
+    XDrawLine(rdpy, d, render_gc, l, t, r, t);
+    XDrawLine(rdpy, d, render_gc, l, t, l, b);
+    XSetForeground(rdpy, render_gc, color + tint);
+    XDrawLine(rdpy, d, render_gc, r, t, r, b);
+    XDrawLine(rdpy, d, render_gc, l, b, r, b);
+  }
+  XSetForeground(rdpy, render_gc, color - tint);
+  XDrawLine(rdpy, d, render_gc, w, 0, w, h);
+  XDrawLine(rdpy, d, render_gc, 0, h, w, h);
+  XSetForeground(rdpy, render_gc, color + tint);
+  XDrawLine(rdpy, d, render_gc, 0, 0, w, 0);
+  XDrawLine(rdpy, d, render_gc, 0, 0, 0, h);
+  auto &tag = shape_text(cache.tag_text, state.tag, w);
+  auto &title = shape_text(cache.title_text, state.title, w - tag.advance - state.border * 6);
+  auto cs = cairo_xlib_surface_create(rdpy, d, DefaultVisual(rdpy, state.screen), w + 1, h + 1);
+  auto c = cairo_create(cs);
+  cairo_set_scaled_font(c, title_font);
+  cairo_set_source_rgb(c, (state.text >> 16 & 0xFF) / 255.0, (state.text >> 8 & 0xFF) / 255.0, (state.text & 0xFF) / 255.0);
+  cairo_translate(c, state.border * 2, state.headline - state.border + 1);
+  cairo_show_glyphs(c, title.glyphs.data(), title.glyphs.size());
+  cairo_translate(c, w - tag.advance - state.border * 4, 0);
+  cairo_show_glyphs(c, tag.glyphs.data(), tag.glyphs.size());
+  cairo_destroy(c);
+  cairo_surface_destroy(cs);
+}
+
+inline Window frame_key (const FrameState& state)
+{
+  return state.frame | (Window) state.connection << 32;
+}
+
+void render (const FrameState& state)
+{
+  rdpy = render_displays[state.connection];
+  auto &gc = render_gcs[state.connection];
+  if (!gc)
+    gc = XCreateGC(rdpy, RootWindow(rdpy, state.screen), 0, 0);
+  render_gc = gc;
+  auto &cache = frame_caches[frame_key(state)];
+  if (state.forget) {
+    for (auto &bg : cache.backgrounds) {
+      if (bg.pixmap) {
+        XFreePixmap(rdpy, bg.pixmap);
+        track(RPixmap, -1);
+      }
+    }
+    frame_caches.erase(frame_key(state));
+    return;
+  }
+  auto &bg = cache.backgrounds[state.active];
+  if (!bg.pixmap || !(bg.state == state)) {
+    if (bg.pixmap) {
+      XFreePixmap(rdpy, bg.pixmap);
+      track(RPixmap, -1);
+    }
+    bg = FrameBackground { XCreatePixmap(rdpy, RootWindow(rdpy, state.screen), state.width + 1, state.height + 1,
+                                         DefaultDepth(rdpy, state.screen)),
+                           state };
+    track(RPixmap, 1);
+    XRenderFrame(cache, state, bg.pixmap);
+  }
+  if (cache.installed != bg.pixmap) {
+    cache.installed = bg.pixmap;
+    XSetWindowBackgroundPixmap(rdpy, state.frame, bg.pixmap);
+    XClearWindow(rdpy, state.frame);
+  }
+}
+
+void render_loop ()
+{
+  log_queue_index = 1;
+  std::unordered_map<Window, const FrameState *> latest;
+  std::vector<Window> order;
+  for (;;) {
+    uint64_t n;
+    if (read(render_wakeup, &n, sizeof(n)) < 0 && errno != EINTR) return;
+    const FrameState *state;
+    while (render_queue.pop(state)) {
+      if (state->forget) {
+        auto i = latest.find(frame_key(*state));
+        if (i != latest.end()) {
+          delete i->second;
+          latest.erase(i);
+        }
+        render(*state);
+        delete state;
+        continue;
+      }
+      auto &slot = latest[frame_key(*state)];
+      if (slot)
+        delete slot;
+      else
+        order.push_back(frame_key(*state));
+      slot = state;
+    }
+    uint64_t one = 1;
+    if (render_blocked.exchange(false))
+      write(render_drained, &one, sizeof(one));
+    for (auto frame : order) {
+      auto i = latest.find(frame);
+      if (i == latest.end()) continue;
+      render(*i->second);
+      delete i->second;
+      latest.erase(i);
+    }
+    order.clear();
+    for (auto d : render_displays)
+      XFlush(d);
+  }
+}
+
+void render_push ()
+{
+  while (!render_backlog.empty() && render_queue.push(render_backlog.front()))
+    render_backlog.pop_front();
+  render_blocked = !render_backlog.empty();
+  uint64_t one = 1;
+  write(render_wakeup, &one, sizeof(one));
+}
+
+void render_submit (const FrameState *state)
+{
+  render_backlog.push_back(state);
+  render_push();
+}
+
+void render_resume ()
+{
+  uint64_t n;
+  read(render_drained, &n, sizeof(n));
+  if (!render_backlog.empty())
+    render_push();
+}
+
+void render_init ()
+{
+  each_connection([] {
+    auto d = XOpenDisplay(DisplayString(dpy));
+    if (!d)
+      err(1, "failed to open render connection");
+    render_displays.push_back(d);
+  });
+  render_gcs.resize(render_displays.size());
+  text_init(render_displays[0]);
+  render_wakeup = eventfd(0, EFD_CLOEXEC);
+  render_drained = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  std::thread(render_loop).detach();
+}
@@ -0,0 +1,88 @@
+#include <map>
+#include <algorithm>
+
+enum ResourceKind { RClient, RWindow, RGC, RCursor, RPixmap, ResourceKinds };
+
+#ifdef RESOURCE_DEBUG
+const char *resource_names[] = { "clients", "windows", "gcs", "cursors", "pixmaps" };
+std::atomic<long> live_resources[ResourceKinds];
+
+inline void track (ResourceKind kind, int delta)
+{
+  live_resources[kind] += delta;
+}
+
+void dump_resources ()
+{
+  long clients = std::max(1L, live_resources[RClient].load());
+  for (int i = 0; i < ResourceKinds; ++i)
+    fprintf(stderr, "%s %ld (%.2f per client)  ", resource_names[i], live_resources[i].load(), (double) live_resources[i] / clients);
+  fprintf(stderr, "\n");
+}
+#else
+inline void track (ResourceKind kind, int delta) {}
+inline void dump_resources () {}
+#endif
+
+template<typename T>
+struct XPtr
+{
+  T *ptr;
+  XPtr (T *ptr = 0) : ptr(ptr) {}
+  ~XPtr () { reset(); }
+  XPtr (const XPtr&) = delete;
+  XPtr& operator = (const XPtr&) = delete;
+  void reset () {
+    if (ptr) XFree(ptr);
+    ptr = 0;
+  }
+  T **out () { reset(); return &ptr; }
+  unsigned char **bytes () { return (unsigned char **) out(); }
+  T *get () const { return ptr; }
+  T& operator [] (int i) const { return ptr[i]; }
+  T *operator -> () const { return ptr; }
+  explicit operator bool () const { return ptr; }
+};
+
+std::map<int, GC> gcs;
+
+GC XSharedGC (int depth)
+{
+  auto i = gcs.find(depth);
+  if (i != gcs.end()) return i->second;
+  GC gc;
+  if (depth == DefaultDepth(dpy, screen_number)) {
+    gc = XCreateGC(dpy, root, 0, 0);
+  } else {
+    Pixmap p = XCreatePixmap(dpy, root, 1, 1, depth);
+    gc = XCreateGC(dpy, p, 0, 0);
+    XFreePixmap(dpy, p);
+  }
+  track(RGC, 1);
+  return gcs[depth] = gc;
+}
+
+const unsigned int CursorShapes[] = {
+  XC_left_ptr, XC_fleur, XC_circle,
+  XC_top_left_corner, XC_top_side, XC_top_right_corner,
+  XC_left_side, XC_right_side,
+  XC_bottom_left_corner, XC_bottom_side, XC_bottom_right_corner,
+};
+
+Cursor cursors[XC_num_glyphs / 2];
+
+Cursor XCursor (unsigned int shape)
+{
+  auto &c = cursors[shape / 2];
+  if (!c) {
+    c = XCreateFontCursor(dpy, shape);
+    track(RCursor, 1);
+  }
+  return c;
+}
+
+void resources_init ()
+{
+  for (auto shape : CursorShapes)
+    XCursor(shape);
+}
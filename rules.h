@@ -0,0 +1,193 @@
+#include <regex>
+#include <fstream>
+#include <unordered_map>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sstream>
+
+struct Placement
+{
+  int x, y, width, height;
+  uint32_t desktop;
+  bool fullscreen, undecorated;
+  bool positioned;
+};
+
+struct Rule
+{
+  std::string cls, instance, role;
+  bool match_title;
+  std::regex title;
+  uint32_t desktop;
+  int geometry;
+  int x, y;
+  unsigned int width, height;
+  int fullscreen, undecorated;
+};
+
+std::vector<Rule> rules;
+std::unordered_map<std::string, std::vector<int>> rules_by_class;
+std::vector<int> rules_any_class;
+
+std::string config_path (const char *name)
+{
+  return std::string(getenv("HOME", "/tmp")) + "/.admiral/" + name;
+}
+
+void rules_load ()
+{
+  rules.clear();
+  rules_by_class.clear();
+  rules_any_class.clear();
+  std::ifstream in(config_path("rules"));
+  std::string line;
+  long number = 0;
+  while (std::getline(in, line)) {
+    ++number;
+    if (line.empty() || line[0] == '#') continue;
+    Rule rule = Rule();
+    rule.fullscreen = rule.undecorated = -1;
+    std::istringstream words(line);
+    std::string word;
+    while (words >> word) {
+      auto eq = word.find('=');
+      auto key = word.substr(0, eq);
+      auto value = eq == std::string::npos ? "" : word.substr(eq + 1);
+      if (key == "class") {
+        rule.cls = value;
+      } else if (key == "instance") {
+        rule.instance = value;
+      } else if (key == "role") {
+        rule.role = value;
+      } else if (key == "title") {
+        try {
+          rule.title = std::regex(value, std::regex::extended | std::regex::nosubs | std::regex::optimize);
+          rule.match_title = true;
+        } catch (std::regex_error&) {
+          log_message(LogCore, LogError, "rules: bad title pattern on line %ld", number);
+        }
+      } else if (key == "desktop") {
+        char *end;
+        long n = strtol(value.c_str(), &end, 10);
+        if (value.empty() || *end || n < 1 || n > DesktopCount)
+          log_message(LogCore, LogError, "rules: bad desktop on line %ld", number);
+        else
+          rule.desktop = 1 << (n - 1);
+      } else if (key == "geometry") {
+        rule.geometry = XParseGeometry(value.c_str(), &rule.x, &rule.y, &rule.width, &rule.height);
+      } else if (key == "fullscreen") {
+        rule.fullscreen = true;
+      } else if (key == "undecorated") {
+        rule.undecorated = true;
+      } else if (key == "decorated") {
+        rule.undecorated = false;
+      }
+    }
+    int index = rules.size();
+    if (rule.cls.empty())
+      rules_any_class.push_back(index);
+    else
+      rules_by_class[rule.cls].push_back(index);
+    rules.push_back(std::move(rule));
+  }
+}
+
+void apply_rule (const Rule& rule, XineramaScreenInfo *s, Placement& place)
+{
+  if (rule.desktop) place.desktop = rule.desktop;
+  if (rule.geometry & WidthValue) place.width = rule.width;
+  if (rule.geometry & HeightValue) place.height = rule.height;
+  if (rule.geometry & XValue)
+    place.x = s->x_org + (rule.geometry & XNegative ? s->width + rule.x - place.width : rule.x);
+  if (rule.geometry & YValue)
+    place.y = s->y_org + (rule.geometry & YNegative ? s->height + rule.y - place.height : rule.y);
+  if (rule.geometry & (XValue | YValue))
+    place.positioned = true;
+  if (rule.fullscreen != -1) place.fullscreen = rule.fullscreen;
+  if (rule.undecorated != -1) place.undecorated = rule.undecorated;
+}
+
+struct LayoutEntry
+{
+  uint32_t hash;
+  uint32_t desktop;
+  int16_t x, y, width, height;
+  char name[48];
+};
+
+const int LayoutSlots = 1024;
+LayoutEntry *layout;
+
+void layout_open ()
+{
+  auto path = config_path("layout");
+  mkdir(config_path("").c_str(), 0700);
+  int fd = open(path.c_str(), O_RDWR | O_CREAT, 0600);
+  if (fd < 0) return;
+  size_t size = sizeof(LayoutEntry) * LayoutSlots;
+  if (ftruncate(fd, size) == 0) {
+    void *p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p != MAP_FAILED) layout = (LayoutEntry *) p;
+  }
+  close(fd);
+}
+
+LayoutEntry *layout_find (const std::string& cls, bool create)
+{
+  if (!layout || cls.empty()) return 0;
+  auto name = cls.substr(0, sizeof(LayoutEntry::name) - 1);
+  uint32_t hash = 2166136261u;
+  for (auto c : name)
+    hash = (hash ^ (unsigned char) c) * 16777619u;
+  hash |= 1;
+  for (int i = 0; i < LayoutSlots; ++i) {
+    auto &e = layout[(hash + i) % LayoutSlots];
+    if (e.hash == hash && name == e.name) return &e;
+    if (!e.hash) {
+      if (!create) return 0;
+      e.hash = hash;
+      strncpy(e.name, name.c_str(), sizeof(e.name) - 1);
+      return &e;
+    }
+  }
+  return 0;
+}
+
+void remember (const std::string& cls, int x, int y, int width, int height, uint32_t desktop)
+{
+  if (auto e = layout_find(cls, true)) {
+    e->x = x;
+    e->y = y;
+    e->width = width;
+    e->height = height;
+    e->desktop = desktop;
+  }
+}
+
+void place (const std::string& cls, const std::string& instance, const std::string& role,
+            const std::string& title, XineramaScreenInfo *s, Placement& place)
+{
+  if (auto e = layout_find(cls, false)) {
+    place.x = e->x;
+    place.y = e->y;
+    place.width = e->width;
+    place.height = e->height;
+    place.desktop = e->desktop;
+    place.positioned = true;
+  }
+  std::vector<int> candidates;
+  auto i = rules_by_class.find(cls);
+  if (i != rules_by_class.end())
+    std::merge(i->second.begin(), i->second.end(), rules_any_class.begin(), rules_any_class.end(),
+               std::back_inserter(candidates));
+  else
+    candidates = rules_any_class;
+  for (auto index : candidates) {
+    auto &rule = rules[index];
+    if (!rule.instance.empty() && rule.instance != instance) continue;
+    if (!rule.role.empty() && rule.role != role) continue;
+    if (rule.match_title && !std::regex_search(title, rule.title)) continue;
+    apply_rule(rule, s, place);
+  }
+}
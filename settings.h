@@ -0,0 +1,108 @@
+
+XrmDatabase settings_db;
+
+const char *setting (const char *name, const char *def)
+{
+  auto n = std::string("admiral.") + name, c = std::string("Admiral.") + name;
+  char *type;
+  XrmValue value;
+  if (settings_db && XrmGetResource(settings_db, n.c_str(), c.c_str(), &type, &value) && value.addr)
+    return value.addr;
+  return def;
+}
+
+int setting (const char *name, int def, int min, int max)
+{
+  auto value = setting(name, (const char *) 0);
+  if (!value) return def;
+  char *end;
+  long n = strtol(value, &end, 10);
+  if (*value && !*end && n >= min && n <= max) return n;
+  log_message(LogCore, LogError, "settings: bad value for %s", name);
+  return def;
+}
+
+std::string frame_colors;
+
+void bar_reset ();
+
+void apply_settings (bool initial)
+{
+  auto &colors = frame_colors;
+  if (settings_db)
+    XrmDestroyDatabase(settings_db);
+  settings_db = XrmGetStringDatabase(getstring(root, "RESOURCE_MANAGER", "").c_str());
+  XrmCombineFileDatabase(config_path("config").c_str(), &settings_db, True);
+  hover_delay = setting("hover-delay", 0, 0, 10000);
+  sync_timeout = setting("sync-timeout", 100, 1, 10000);
+  ping_timeout = setting("ping-timeout", 2000, 1, 600000);
+  kill_delay = setting("kill-delay", 5000, 0, 600000);
+  load_interval = setting("load-interval", 500, 10, 600000);
+  auto level = setting("log-level", "error");
+  for (int i = 0; i < LogSubsystems; ++i)
+    log_levels[i] = log_level(setting((std::string("log.") + log_subsystem_names[i]).c_str(), level));
+  std::string active = setting("active-color", "rgb:44/44/88"),
+              inactive = setting("inactive-color", "rgb:cc/cc/cc"),
+              text = setting("text-color", "rgb:cc/cc/cc"),
+              inactive_text = setting("inactive-text-color", "rgb:80/80/80");
+  bool colors_changed = colors != active + inactive + text + inactive_text;
+  if (colors_changed) {
+    colors = active + inactive + text + inactive_text;
+    active_frame_pixel = XMakeColor(dpy, active.c_str());
+    inactive_frame_pixel = XMakeColor(dpy, inactive.c_str());
+    frame_text_pixel = XMakeColor(dpy, text.c_str());
+    inactive_text_pixel = XMakeColor(dpy, inactive_text.c_str());
+  }
+  int border = setting("border-width", 5, 1, 64),
+      headline = setting("headline-height", 20, 1, 256);
+  bool extents_changed = border != BorderWidth || headline != HeadlineHeight;
+  BorderWidth = border;
+  HeadlineHeight = headline;
+  if (initial) {
+    load_overlay = !strcmp(setting("load", "off"), "on");
+    return;
+  }
+  for (auto i = clients.begin(); i != clients.end(); ++i) {
+    auto &client = *i->second;
+    if (i->first != client.frame) continue;
+    if (extents_changed && !client.undecorated)
+      move_resize(client, client.x, client.y, client.width, client.height);
+    else if (colors_changed)
+      XDrawFrame(client, &client == focused);
+  }
+  if (extents_changed)
+    bar_reset();
+  else if (colors_changed)
+    bar_update(true);
+}
+
+void reload_settings ()
+{
+  each_connection([] { apply_settings(false); });
+  load_refresh();
+  rules_load();
+}
+
+void settings_init ()
+{
+  XrmInitialize();
+  each_connection([] { apply_settings(true); });
+  mkdir(config_path("").c_str(), 0700);
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0 || inotify_add_watch(fd, config_path("").c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    return;
+  watch_fd(fd, [fd] {
+    char buf[4096] __attribute__((aligned(__alignof__(inotify_event))));
+    bool changed = false;
+    ssize_t len;
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+      for (char *p = buf; p < buf + len; p += sizeof(inotify_event) + ((inotify_event *) p)->len) {
+        auto e = (inotify_event *) p;
+        if (e->len && (!strcmp(e->name, "config") || !strcmp(e->name, "rules")))
+          changed = true;
+      }
+    }
+    if (changed)
+      reload_settings();
+  });
+}
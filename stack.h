@@ -0,0 +1,108 @@
+
+enum Layer { LayerDesktop, LayerNormal, LayerAbove, LayerDock, LayerFullscreen };
+
+std::vector<XClient *> stack_order;
+std::vector<Window> stacked_frames;
+extern std::vector<Window> bar_windows;
+
+Layer layer (XClient& client)
+{
+  if (client.fullscreen) return LayerFullscreen;
+  if (client.type == atom("_NET_WM_WINDOW_TYPE_DOCK")) return LayerDock;
+  if (client.type == atom("_NET_WM_WINDOW_TYPE_DESKTOP")) return LayerDesktop;
+  if (client.above) return LayerAbove;
+  return LayerNormal;
+}
+
+void stack_layer (XClient& client)
+{
+  client.layer = layer(client);
+}
+
+void restack ()
+{
+  std::stable_sort(stack_order.begin(), stack_order.end(),
+                   [] (XClient *a, XClient *b) { return a->layer < b->layer; });
+  int budget = stack_order.size() * 2;
+  for (size_t i = 0; i < stack_order.size() && budget > 0; ++i) {
+    auto c = stack_order[i];
+    if (!c->transient_for || !IsClient(c->transient_for)) continue;
+    auto self = stack_order.begin() + i;
+    auto parent = std::find(stack_order.begin(), stack_order.end(), clients[c->transient_for]);
+    if (parent > self && parent != stack_order.end()) {
+      std::rotate(self, self + 1, parent + 1);
+      --i, --budget;
+    }
+  }
+  std::vector<Window> frames, children;
+  bool bars_placed = false;
+  for (auto i = stack_order.rbegin(); i != stack_order.rend(); ++i) {
+    if (!bars_placed && (*i)->layer <= LayerDock) {
+      frames.insert(frames.end(), bar_windows.begin(), bar_windows.end());
+      bars_placed = true;
+    }
+    frames.push_back((*i)->frame);
+  }
+  if (!bars_placed)
+    frames.insert(frames.end(), bar_windows.begin(), bar_windows.end());
+  if (frames != stacked_frames && !frames.empty()) {
+    size_t k = 0, end = frames.size(), j = stacked_frames.size();
+    while (k < end && k < j && frames[k] == stacked_frames[k])
+      ++k;
+    while (end > k && j > k && frames[end - 1] == stacked_frames[j - 1])
+      --end, --j;
+    if (k == 0)
+      backend->raise_window(frames[0]);
+    else
+      --k;
+    if (end - k > 1)
+      backend->restack_windows(frames.data() + k, end - k);
+  }
+  stacked_frames = frames;
+  for (auto c : stack_order)
+    if (c->mapped)
+      children.push_back(c->child);
+  ewmh_set_stacking(children);
+}
+
+void stack_add (XClient& client)
+{
+  stack_layer(client);
+  stack_order.push_back(&client);
+  restack();
+}
+
+void stack_remove (XClient& client)
+{
+  stack_order.erase(std::remove(stack_order.begin(), stack_order.end(), &client), stack_order.end());
+  stacked_frames.erase(std::remove(stacked_frames.begin(), stacked_frames.end(), client.frame), stacked_frames.end());
+  restack();
+}
+
+void stack_raise (XClient& client)
+{
+  auto i = std::find(stack_order.begin(), stack_order.end(), &client);
+  if (i == stack_order.end()) return;
+  std::rotate(i, i + 1, stack_order.end());
+  restack();
+}
+
+void stack_lower (XClient& client)
+{
+  auto i = std::find(stack_order.begin(), stack_order.end(), &client);
+  if (i == stack_order.end()) return;
+  std::rotate(stack_order.begin(), i, i + 1);
+  restack();
+}
+
+void stack_place (XClient& client, XClient& sibling, bool above)
+{
+  auto i = std::find(stack_order.begin(), stack_order.end(), &client);
+  auto j = std::find(stack_order.begin(), stack_order.end(), &sibling);
+  if (i == stack_order.end() || j == stack_order.end() || i == j) return;
+  if (i < j)
+    std::rotate(i, i + 1, above ? j + 1 : j);
+  else
+    std::rotate(above ? j + 1 : j, i, i + 1);
+  restack();
+}
@@ -0,0 +1,99 @@
+int sync_event_base, sync_error_base;
+std::map<XSyncAlarm, XClient *> sync_alarms;
+
+bool sync_init ()
+{
+  int major, minor;
+  return XSyncQueryExtension(dpy, &sync_event_base, &sync_error_base)
+    && XSyncInitialize(dpy, &major, &minor);
+}
+
+void sync_request (XClient& client);
+
+void sync_resize (XClient& client, int x, int y, int width, int height)
+{
+  if (client.sync_pending) {
+    client.sync_deferred = true;
+    client.sync_next[0] = x;
+    client.sync_next[1] = y;
+    client.sync_next[2] = width;
+    client.sync_next[3] = height;
+    return;
+  }
+  if (client.sync_counter && !client.fullscreen && (width != client.width || height != client.height))
+    sync_request(client);
+  move_resize(client, x, y, width, height);
+}
+
+void sync_done (XClient& client)
+{
+  client.sync_pending = false;
+  cancel_timer(client.sync_timer);
+  if (client.sync_deferred) {
+    client.sync_deferred = false;
+    sync_resize(client, client.sync_next[0], client.sync_next[1], client.sync_next[2], client.sync_next[3]);
+  }
+}
+
+void sync_request (XClient& client)
+{
+  XSyncValue value;
+  if (!client.sync_alarm) {
+    if (!XSyncQueryCounter(dpy, client.sync_counter, &value)) {
+      client.sync_counter = None;
+      return;
+    }
+    client.sync_value = (int64_t) XSyncValueHigh32(value) << 32 | XSyncValueLow32(value);
+  }
+  ++client.sync_value;
+  XSyncIntsToValue(&value, client.sync_value & 0xFFFFFFFF, client.sync_value >> 32);
+  XSyncAlarmAttributes attr;
+  attr.trigger.wait_value = value;
+  if (!client.sync_alarm) {
+    attr.trigger.counter = client.sync_counter;
+    attr.trigger.value_type = XSyncAbsolute;
+    attr.trigger.test_type = XSyncPositiveComparison;
+    XSyncIntToValue(&attr.delta, 0);
+    attr.events = True;
+    client.sync_alarm = XSyncCreateAlarm(dpy, XSyncCACounter | XSyncCAValueType | XSyncCAValue
+                                         | XSyncCATestType | XSyncCADelta | XSyncCAEvents, &attr);
+    sync_alarms[client.sync_alarm] = &client;
+  } else {
+    XSyncChangeAlarm(dpy, client.sync_alarm, XSyncCAValue, &attr);
+  }
+  XClientMessageEvent cme = {};
+  cme.type = ClientMessage;
+  cme.window = client.child;
+  cme.message_type = atom("WM_PROTOCOLS");
+  cme.format = 32;
+  cme.data.l[0] = atom("_NET_WM_SYNC_REQUEST");
+  cme.data.l[1] = CurrentTime;
+  cme.data.l[2] = XSyncValueLow32(value);
+  cme.data.l[3] = XSyncValueHigh32(value);
+  XSendEvent(dpy, client.child, False, 0, (XEvent *) &cme);
+  client.sync_pending = true;
+  auto child = client.child;
+  client.sync_timer = add_timer(sync_timeout * 1000L, [child] {
+    auto &client = XFindClient(child, False);
+    if (!&client) return;
+    client.sync_timer = 0;
+    ++stats.sync_timeouts;
+    sync_done(client);
+  });
+}
+
+void sync_alarm (XSyncAlarmNotifyEvent& event)
+{
+  auto i = sync_alarms.find(event.alarm);
+  if (i != sync_alarms.end() && i->second->sync_pending)
+    sync_done(*i->second);
+}
+
+void sync_forget (XClient& client)
+{
+  cancel_timer(client.sync_timer);
+  if (!client.sync_alarm) return;
+  XSyncDestroyAlarm(dpy, client.sync_alarm);
+  sync_alarms.erase(client.sync_alarm);
+  client.sync_alarm = None;
+}
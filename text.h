@@ -0,0 +1,80 @@
+#include <unordered_map>
+#include <cairo/cairo.h>
+#include <cairo/cairo-xlib.h>
+
+struct TextCache
+{
+  std::string text;
+  int width = -1;
+  double advance = 0;
+  std::vector<cairo_glyph_t> glyphs;
+};
+
+cairo_t *text_context;
+cairo_scaled_font_t *title_font;
+thread_local std::unordered_map<uint32_t, double> advances;
+
+void text_init (Display *dpy)
+{
+  auto face = cairo_toy_font_face_create("sans-serif", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+  auto cs = cairo_xlib_surface_create(dpy, DefaultRootWindow(dpy), DefaultVisual(dpy, DefaultScreen(dpy)), 1, 1);
+  text_context = cairo_create(cs);
+  cairo_surface_destroy(cs);
+  cairo_set_font_face(text_context, face);
+  cairo_font_face_destroy(face);
+  title_font = cairo_get_scaled_font(text_context);
+}
+
+inline int utf8_length (const std::string& s, size_t i)
+{
+  unsigned char c = s[i];
+  int len = c < 0xC0 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+  return std::min<size_t>(len, s.size() - i);
+}
+
+double advance (const std::string& s, size_t i, int len)
+{
+  uint32_t key = 0;
+  memcpy(&key, s.data() + i, len);
+  auto a = advances.find(key);
+  if (a != advances.end()) return a->second;
+  cairo_text_extents_t te;
+  cairo_scaled_font_text_extents(title_font, s.substr(i, len).c_str(), &te);
+  return advances[key] = te.x_advance;
+}
+
+double text_width (const std::string& s)
+{
+  double total = 0;
+  for (size_t i = 0, len; i < s.size(); i += len)
+    total += advance(s, i, len = utf8_length(s, i));
+  return total;
+}
+
+std::string fit_text (const std::string& s, double width)
+{
+  static const std::string ellipsis = "…";
+  double total = 0, room = width - text_width(ellipsis);
+  size_t fits = 0;
+  for (size_t i = 0, len; i < s.size(); i += len) {
+    total += advance(s, i, len = utf8_length(s, i));
+    if (total > width) return s.substr(0, fits) + ellipsis;
+    if (total <= room) fits = i + len;
+  }
+  return s;
+}
+
+TextCache& shape_text (TextCache& cache, const std::string& text, int width)
+{
+  if (cache.width == width && cache.text == text) return cache;
+  cache.text = text;
+  cache.width = width;
+  auto fitted = fit_text(text, width);
+  cache.advance = text_width(fitted);
+  cairo_glyph_t *glyphs = 0;
+  int count = 0;
+  cairo_scaled_font_text_to_glyphs(title_font, 0, 0, fitted.data(), fitted.size(), &glyphs, &count, 0, 0, 0);
+  cache.glyphs.assign(glyphs, glyphs + count);
+  cairo_glyph_free(glyphs);
+  return cache;
+}
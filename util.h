@@ -11,6 +11,79 @@ const char *XGetDefault (Display *dpy, const char *program, const char *option,
   return s ? s : def;
 }
 
+template<typename T, unsigned N>
+struct SpscQueue
+{
+  T items[N];
+  std::atomic<unsigned> head {0}, tail {0};
+  bool push (const T& item) {
+    auto t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == N) return false;
+    items[t % N] = item;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+  bool pop (T& item) {
+    auto h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return false;
+    item = items[h % N];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+inline long now_us ()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+typedef unsigned Timer;
+std::multimap<long, std::pair<Timer, std::function<void ()>>> timers;
+Timer last_timer;
+
+Timer add_timer (long delay_us, std::function<void ()> fn, Connection *c = active_connection)
+{
+  if (!++last_timer) ++last_timer;
+  timers.insert(std::make_pair(now_us() + delay_us, std::make_pair(last_timer, [c, fn] { activate(c); fn(); })));
+  return last_timer;
+}
+
+void cancel_timer (Timer& timer)
+{
+  for (auto i = timers.begin(); timer && i != timers.end(); ++i) {
+    if (i->second.first == timer) {
+      timers.erase(i);
+      break;
+    }
+  }
+  timer = 0;
+}
+
+int run_timers ()
+{
+  auto now = now_us();
+  while (!timers.empty() && timers.begin()->first <= now) {
+    auto fn = timers.begin()->second.second;
+    timers.erase(timers.begin());
+    fn();
+  }
+  if (timers.empty()) return -1;
+  return (timers.begin()->first - now + 999) / 1000;
+}
+
+const std::string& hostname ()
+{
+  static std::string name;
+  if (name.empty()) {
+    char buf[256] = {};
+    gethostname(buf, sizeof(buf) - 1);
+    name = buf;
+  }
+  return name;
+}
+
 int spawn (const char *command) {
   int pid = fork();
   if (pid) return pid;
@@ -21,7 +94,7 @@ int spawn (const char *command) {
 inline unsigned long XMakeColor (Display *dpy, const char *s)
 {
   XColor color;
-  Colormap cm = DefaultColormap(dpy, 0);
+  Colormap cm = DefaultColormap(dpy, screen_number);
   XParseColor(dpy, cm, s, &color);
   XAllocColor(dpy, cm, &color);
   return color.pixel;
@@ -2,15 +2,34 @@
 int screen_count;
 
 const char *command;
+char **arguments;
 
 XWindowAttributes attr;
 XButtonEvent start;
 int hf, vf;
 Display *dpy;
-Window root, bar;
+Window root;
+int screen_number, connection_index;
 uint32_t current_desktop;
+std::vector<uint32_t> monitor_desktops;
+int current_monitor;
+int hover_delay, sync_timeout, ping_timeout, kill_delay, load_interval;
+bool load_overlay;
+
+struct Stats
+{
+  long focus_changes, focus_skipped, hover_cancelled, redraws_avoided, sync_timeouts, configure_requests, configure_unchanged;
+} stats;
+
+volatile sig_atomic_t dump_requested, reload_requested;
 
 unsigned int active_frame_pixel;
 unsigned int frame_text_pixel;
 unsigned int inactive_frame_pixel;
+unsigned int inactive_text_pixel;
+
+struct Connection;
+Connection *active_connection;
+void activate (Connection *c);
+void each_connection (std::function<void ()> fn);
 
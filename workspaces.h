@@ -1,34 +1,84 @@
 
 extern std::map<Window, XClient *> clients;
 
-void set_desktop (uint32_t num)
+void select_monitor (int monitor)
+{
+  if (monitor == current_monitor) return;
+  current_monitor = monitor;
+  if (ewmh_desktop(monitor_desktops[monitor]) != ewmh_desktop(current_desktop))
+    ewmh_set_current_desktop(monitor_desktops[monitor]);
+  current_desktop = monitor_desktops[monitor];
+}
+
+void set_desktop (int monitor, uint32_t num)
 {
+  monitor_desktops[monitor] = num;
+  current_monitor = monitor;
   current_desktop = num;
   for (auto i = clients.begin(); i != clients.end(); ++i) {
     auto &client = *i->second;
-    if (&client) {
+    if (&client && client.monitor == monitor) {
       if (client.desktop & num && client.mapped) {
-        XMapWindow(dpy, client.frame);
+        if (!client.viewable)
+          backend->map_window(client.frame);
+        client.viewable = true;
         XDrawFrame(client, &client == focused);
       } else {
-        XUnmapWindow(dpy, client.frame);
+        if (client.viewable)
+          backend->unmap_window(client.frame);
+        client.viewable = false;
       }
     }
   }
-  setprop<long>(root, "_NET_CURRENT_DESKTOP", num);
+  std::vector<long> desktops(monitor_desktops.begin(), monitor_desktops.end());
+  ewmh_set_current_desktop(num);
+  setlist(root, "_ADMIRAL_MONITOR_DESKTOPS", "CARDINAL", desktops.data(), desktops.size());
+  focus_fallback();
+  bar_update();
+}
+
+void set_desktop (uint32_t num)
+{
+  set_desktop(current_screen() - screens, num);
 }
 
 void set_desktop (XClient& client, uint32_t num)
 {
   if (!&client) return;
+  freespace_update(client);
+  mru_remove(client);
   client.desktop = num;
-  set_desktop(current_desktop);
-  setprop<long>(client.child, "_NET_WM_DESKTOP", num);
+  mru_touch(client);
+  freespace_update(client);
+  set_desktop(client.monitor, monitor_desktops[client.monitor]);
+  ewmh_set_desktop(client.child, num);
+}
+
+void set_monitor (XClient& client, int monitor)
+{
+  mru_remove(client);
+  client.monitor = monitor;
+  mru_touch(client);
+  auto shown = monitor_desktops[monitor];
+  if (client.mapped && !(client.desktop & shown))
+    set_desktop(client, shown & -shown);
 }
 
 void flip_desktop (uint32_t num)
 {
-  set_desktop(current_desktop ^ num);
+  int monitor = current_screen() - screens;
+  set_desktop(monitor, monitor_desktops[monitor] ^ num);
+}
+
+void shift_desktop (int direction)
+{
+  int monitor = current_screen() - screens;
+  uint32_t num = direction < 0 ? monitor_desktops[monitor] >> 1 : monitor_desktops[monitor] << 1;
+  if (num == 0)
+    num = 1 << (DesktopCount - 1);
+  if (num == 1 << DesktopCount)
+    num = 1;
+  set_desktop(monitor, num);
 }
 
 void flip_desktop (XClient& client, uint32_t num)
@@ -1,65 +1,63 @@
 
 Atom atom (const char *name)
 {
-  return XInternAtom(dpy, name, False);
+  return backend->intern_atom(name);
 }
 
 template<typename T, typename T2>
 void setprop (Window w, const char *name, const T2 &value)
 {
-  auto atom = XInternAtom(dpy, name, True);
+  auto property = atom(name);
   T temp = value;
-  XChangeProperty(dpy, w, atom, atom, 8, PropModeReplace, (unsigned char *) &temp, sizeof(temp));
+  backend->change_property(w, property, property, 8, PropModeReplace, &temp, sizeof(temp));
 }
 
 template<int I>
 void setprop (Window w, const char *name, const long (&value)[I])
 {
-  XChangeProperty(dpy, w, atom(name), atom("CARDINAL"), 32, PropModeReplace, (unsigned char *) value, I);
+  backend->change_property(w, atom(name), atom("CARDINAL"), 32, PropModeReplace, value, I);
 }
 
 template<typename T, typename T2>
 T getprop (Window w, const char *name, const T2 def)
 {
   auto atom = XInternAtom(dpy, name, False);
-  T *prop, val;
+  XPtr<T> prop;
   Atom type;
   int format;
   unsigned long items, bytes;
   XGetWindowProperty(dpy, w, atom, 0, sizeof(T) / 4 + 1,
                      False, AnyPropertyType,
                      &type, &format, &items, &bytes,
-                     (unsigned char **) &prop);
-  val = prop ? *prop : def;
-  if (prop) XFree(prop);
-  return val;
+                     prop.bytes());
+  return prop ? *prop.get() : def;
 }
 
 bool hasprop (Window w, const char *name)
 {
   auto atom = XInternAtom(dpy, name, False);
-  void *prop;
+  XPtr<unsigned char> prop;
   Atom type;
   int format;
   unsigned long items, bytes;
   XGetWindowProperty(dpy, w, atom, 0, 0,
                      False, AnyPropertyType,
                      &type, &format, &items, &bytes,
-                     (unsigned char **) &prop);
+                     prop.out());
   return bytes != 0;
 }
 
 int proplen (Window w, const char *name)
 {
   auto atom = XInternAtom(dpy, name, False);
-  const char *prop;
+  XPtr<unsigned char> prop;
   Atom type;
   int format;
   unsigned long items, bytes;
   XGetWindowProperty(dpy, w, atom, 0, 0,
                      False, AnyPropertyType,
                      &type, &format, &items, &bytes,
-                     (unsigned char **) &prop);
+                     prop.out());
   return bytes;
 }
 
@@ -67,13 +65,13 @@ template<typename T>
 bool getstruct (Window w, const char *name, int format, T &data)
 {
   if (hasprop(w, name)) {
-    unsigned char *prop;
+    XPtr<unsigned char> prop;
     Atom type;
     int format;
     unsigned long items, bytes;
-    XGetWindowProperty(dpy, w, atom(name), 0, sizeof(data), False, AnyPropertyType, &type, &format, &items, &bytes, &prop);
-    memcpy(&data, prop, sizeof(data));
-    XFree(prop);
+    XGetWindowProperty(dpy, w, atom(name), 0, sizeof(data), False, AnyPropertyType, &type, &format, &items, &bytes, prop.out());
+    if (!prop) return false;
+    memcpy(&data, prop.get(), sizeof(data));
     return true;
   } else {
     return false;
@@ -85,7 +83,7 @@ std::string getprop<std::string, const char *> (Window w, const char *name, cons
 {
   if (hasprop(w, name)) {
     auto atom = XInternAtom(dpy, name, False);
-    const char *prop, *val;
+    XPtr<char> prop;
     Atom type;
     int format;
     int len = proplen(w, name);
@@ -93,8 +91,8 @@ std::string getprop<std::string, const char *> (Window w, const char *name, cons
     XGetWindowProperty(dpy, w, atom, 0, len,
                        False, AnyPropertyType,
                        &type, &format, &items, &bytes,
-                       (unsigned char **) &prop);
-    return prop;
+                       prop.bytes());
+    return prop ? prop.get() : def;
   } else {
     return def;
   }
@@ -126,12 +124,7 @@ XineramaScreenInfo *find_screen (int x, int y)
 
 XPoint pointer ()
 {
-  int x, y;
-  Window a, b;
-  int c, d;
-  unsigned int e;
-  XQueryPointer(dpy, root, &a, &b, &x, &y, &c, &d, &e);
-  return XPoint{(short)x, (short)y};
+  return backend->query_pointer();
 }
 
 XineramaScreenInfo *current_screen ()
@@ -143,3 +136,20 @@ XineramaScreenInfo *current_screen ()
   XPoint p = pointer();
   return find_screen(p.x, p.y);
 }
+
+void setlist (Window w, const char *name, const char *type, const void *data, int count, int mode = PropModeReplace)
+{
+  backend->change_property(w, atom(name), atom(type), 32, mode, data, count);
+}
+
+std::vector<long> getlist (Window w, const char *name)
+{
+  XPtr<long> prop;
+  Atom type;
+  int format;
+  unsigned long items = 0, bytes;
+  XGetWindowProperty(dpy, w, atom(name), 0, 1024, False, AnyPropertyType,
+                     &type, &format, &items, &bytes, prop.bytes());
+  if (!prop || format != 32) return std::vector<long>();
+  return std::vector<long>(prop.get(), prop.get() + items);
+}